@@ -19,7 +19,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 #include "g_local.h"
 
-static void SetChaseStats(gclient_t *client)
+// view of a chased player, computed once and shared by all its chasers
+typedef struct {
+    edict_t *targ;
+    vec3_t  goal;       // camera origin for servers without GMF_CLIENTNUM
+    int     viewid;     // -1 if not computed yet
+} chase_view_t;
+
+static void SetChaseStats(gclient_t *client, chase_view_t *view)
 {
     edict_t *targ = client->chase_target;
     int playernum = (targ - g_edicts) - 1;
@@ -42,15 +49,15 @@ static void SetChaseStats(gclient_t *client)
     if (client->pers.noviewid || client->layout == LAYOUT_MOTD) {
         client->ps.stats[STAT_VIEWID] = 0;
     } else if (targ->client->pers.noviewid) {
-        client->ps.stats[STAT_VIEWID] = G_GetPlayerIdView(targ);
+        if (view->viewid == -1)
+            view->viewid = G_GetPlayerIdView(targ);
+        client->ps.stats[STAT_VIEWID] = view->viewid;
     }
 }
 
-static void UpdateChaseCamHack(gclient_t *client)
+static void ChaseCamGoal(edict_t *targ, vec3_t goal)
 {
-    vec3_t o, ownerv, goal;
-    edict_t *ent = client->edict;
-    edict_t *targ = client->chase_target;
+    vec3_t o, ownerv;
     vec3_t forward, right;
     trace_t trace;
     vec3_t angles;
@@ -95,6 +102,12 @@ static void UpdateChaseCamHack(gclient_t *client)
         VectorCopy(trace.endpos, goal);
         goal[2] += 6;
     }
+}
+
+static void UpdateChaseCamHack(gclient_t *client, const vec3_t goal)
+{
+    edict_t *ent = client->edict;
+    edict_t *targ = client->chase_target;
 
     if (targ->deadflag)
         client->ps.pmove.pm_type = PM_DEAD;
@@ -142,38 +155,141 @@ static void UpdateChaseCam(gclient_t *client)
     ent->viewheight = targ->viewheight;
 }
 
-void SetChaseTarget(edict_t *ent, edict_t *targ)
+static void InitChaseView(chase_view_t *view, edict_t *targ)
 {
-    int i;
+    view->targ = targ;
+    view->viewid = -1;
+    if (!(game.serverFeatures & GMF_CLIENTNUM)) {
+        ChaseCamGoal(targ, view->goal);
+    }
+    level.perf.chase_views++;
+}
 
-    ent->client->chase_target = targ;
+static void ApplyChaseView(gclient_t *c, chase_view_t *view)
+{
+    // camera
+    if (game.serverFeatures & GMF_CLIENTNUM) {
+        UpdateChaseCam(c);
+    } else {
+        UpdateChaseCamHack(c, view->goal);
+    }
 
-    // stop chasecam
-    if (!targ) {
-        ent->client->clientNum = (ent - g_edicts) - 1;
-        ent->client->ps.pmove.pm_flags = 0;
-        ent->client->ps.pmove.pm_type = PM_SPECTATOR;
-        ent->client->ps.viewangles[ROLL] = 0;
-        G_SetDeltaAngles(ent, ent->client->ps.viewangles);
-        VectorCopy(ent->client->ps.viewangles, ent->s.angles);
-        VectorCopy(ent->client->ps.viewangles, ent->client->v_angle);
-        VectorScale(ent->client->ps.pmove.origin, 0.125f, ent->s.origin);
-        ent->client->chase_mode = CHASE_NONE;
-        ClientEndServerFrame(ent);
+    // stats
+    SetChaseStats(c, view);
+    level.perf.chase_updates++;
+}
+
+/*
+=================
+Chaser lists
+
+Spectators chasing each player, linked by client number + 1 so that
+lists survive clients being cleared. Entries are checked against
+chase_target when walked, stale ones are skipped.
+=================
+*/
+static int  chase_head[MAX_CLIENTS];
+static int  chase_next[MAX_CLIENTS];
+static int  chase_prev[MAX_CLIENTS];
+static int  chase_list[MAX_CLIENTS];    // list client is linked into
+
+static void UnlinkChaser(int num)
+{
+    int list = chase_list[num];
+
+    if (!list) {
+        return;
+    }
+
+    if (chase_prev[num]) {
+        chase_next[chase_prev[num] - 1] = chase_next[num];
     } else {
-        ent->client->clientNum = (targ - g_edicts) - 1;
-        for (i = 0; i < PCS_TOTAL; i++) {
-            G_PrivateString(ent, i, targ->client->level.strings[i]);
+        chase_head[list - 1] = chase_next[num];
+    }
+    if (chase_next[num]) {
+        chase_prev[chase_next[num] - 1] = chase_prev[num];
+    }
+
+    chase_list[num] = chase_next[num] = chase_prev[num] = 0;
+}
+
+static void LinkChaser(int num, int list)
+{
+    chase_next[num] = chase_head[list];
+    chase_prev[num] = 0;
+    if (chase_head[list]) {
+        chase_prev[chase_head[list] - 1] = num + 1;
+    }
+    chase_head[list] = num + 1;
+    chase_list[num] = list + 1;
+}
+
+int G_GetChasers(edict_t *targ, edict_t **chasers)
+{
+    gclient_t *client;
+    int i, count = 0;
+
+    for (i = chase_head[(targ - g_edicts) - 1]; i; i = chase_next[i - 1]) {
+        client = &game.clients[i - 1];
+        if (client->pers.connected != CONN_SPECTATOR) {
+            continue;
+        }
+        if (client->chase_target != targ) {
+            continue;
         }
+        chasers[count++] = client->edict;
+    }
+
+    return count;
+}
+
+static void AttachChaser(edict_t *ent, edict_t *targ)
+{
+    int i;
+
+    ent->client->chase_target = targ;
+    UnlinkChaser((ent - g_edicts) - 1);
+    LinkChaser((ent - g_edicts) - 1, (targ - g_edicts) - 1);
+    G_DirtyScoreboard();
+
+    ent->client->clientNum = (targ - g_edicts) - 1;
+    for (i = 0; i < PCS_TOTAL; i++) {
+        G_PrivateString(ent, i, targ->client->level.strings[i]);
+    }
+}
+
+void SetChaseTarget(edict_t *ent, edict_t *targ)
+{
+    if (targ) {
+        AttachChaser(ent, targ);
         ChaseEndServerFrame(ent);
+        return;
     }
+
+    ent->client->chase_target = NULL;
+    UnlinkChaser((ent - g_edicts) - 1);
+    G_DirtyScoreboard();
+
+    // stop chasecam
+    ent->client->clientNum = (ent - g_edicts) - 1;
+    ent->client->ps.pmove.pm_flags = 0;
+    ent->client->ps.pmove.pm_type = PM_SPECTATOR;
+    ent->client->ps.viewangles[ROLL] = 0;
+    G_SetDeltaAngles(ent, ent->client->ps.viewangles);
+    VectorCopy(ent->client->ps.viewangles, ent->s.angles);
+    VectorCopy(ent->client->ps.viewangles, ent->client->v_angle);
+    VectorScale(ent->client->ps.pmove.origin, 0.125f, ent->s.origin);
+    ent->client->chase_mode = CHASE_NONE;
+    ClientEndServerFrame(ent);
 }
 
 void UpdateChaseTargets(chase_mode_t mode, edict_t *targ)
 {
     edict_t *other;
+    chase_view_t view;
     int i;
 
+    view.targ = NULL;
     for (i = 1; i <= game.maxclients; i++) {
         other = &g_edicts[i];
         if (!other->inuse) {
@@ -185,9 +301,14 @@ void UpdateChaseTargets(chase_mode_t mode, edict_t *targ)
         if (other->client->chase_mode != mode) {
             continue;
         }
-        if (other->client->chase_target != targ) {
-            SetChaseTarget(other, targ);
+        if (other->client->chase_target == targ) {
+            continue;
+        }
+        AttachChaser(other, targ);
+        if (!view.targ) {
+            InitChaseView(&view, targ);
         }
+        ApplyChaseView(other->client, &view);
     }
 }
 
@@ -274,6 +395,7 @@ bool GetChaseTarget(edict_t *ent, chase_mode_t mode)
 void ChaseEndServerFrame(edict_t *ent)
 {
     gclient_t *c = ent->client;
+    chase_view_t view;
 
     if (!c->chase_target) {
         return;
@@ -287,13 +409,50 @@ void ChaseEndServerFrame(edict_t *ent)
         }
     }
 
-    // camera
-    if (game.serverFeatures & GMF_CLIENTNUM) {
-        UpdateChaseCam(c);
-    } else {
-        UpdateChaseCamHack(c);
+    InitChaseView(&view, c->chase_target);
+    ApplyChaseView(c, &view);
+}
+
+/*
+=================
+ChaseEndServerFrames
+
+Updates all chasecam clients, computing the view of
+each chased player only once.
+=================
+*/
+void ChaseEndServerFrames(void)
+{
+    edict_t *chasers[MAX_CLIENTS];
+    edict_t *targ;
+    gclient_t *c;
+    chase_view_t view;
+    int i, j, count;
+
+    // pick new targets for clients whose target is gone
+    for (i = 0, c = game.clients; i < game.maxclients; i++, c++) {
+        if (c->pers.connected <= CONN_CONNECTED) {
+            continue;
+        }
+        if (c->chase_target && !PlayerSpawned(c->chase_target)) {
+            if (!ChaseNext(c->edict)) {
+                SetChaseTarget(c->edict, NULL);
+            }
+        }
     }
 
-    // stats
-    SetChaseStats(c);
+    for (i = 1; i <= game.maxclients; i++) {
+        targ = &g_edicts[i];
+        if (!targ->inuse || !PlayerSpawned(targ)) {
+            continue;
+        }
+        count = G_GetChasers(targ, chasers);
+        if (!count) {
+            continue;
+        }
+        InitChaseView(&view, targ);
+        for (j = 0; j < count; j++) {
+            ApplyChaseView(chasers[j]->client, &view);
+        }
+    }
 }
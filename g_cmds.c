@@ -1220,6 +1220,8 @@ void Cmd_Settings_f(edict_t *ent)
         s = "avoid closest (bugged)";
     } else if ((int)g_spawn_mode->value == 1) {
         s = "avoid closest";
+    } else if ((int)g_spawn_mode->value == 3) {
+        s = "out of sight";
     } else {
         s = "random";
     }
@@ -1531,6 +1533,7 @@ static void Cmd_Ready_f(edict_t *ent, bool ready)
 
     ent->client->resp.ready = ready;
     ent->client->resp.ready_framenum = level.framenum;
+    G_DirtyScoreboard();
     gi.bprintf(PRINT_HIGH, "%s is %sready!\n", ent->client->pers.netname, ready ? "" : "not ");
 
     G_CheckMatchStart();
@@ -1553,6 +1556,7 @@ static void Cmd_ForceReady_f(edict_t *ent, bool ready)
             c->resp.ready_framenum = 0;
         }
     }
+    G_DirtyScoreboard();
 
     G_CheckMatchStart();
 }
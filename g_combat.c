@@ -21,19 +21,64 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "g_local.h"
 
+// results of line of sight traces done during one T_RadiusDamage call,
+// all of them start at the same inflictor origin
+#define MAX_CANDAMAGE_TRACES    64
+
+typedef struct {
+    int     count;
+    vec3_t  dest[MAX_CANDAMAGE_TRACES];
+    bool    clear[MAX_CANDAMAGE_TRACES];
+} candamage_cache_t;
+
+static candamage_cache_t    *candamage_cache;
+
+static bool CanDamageTrace(edict_t *inflictor, const vec3_t dest)
+{
+    candamage_cache_t *cache = candamage_cache;
+    trace_t trace;
+    int i;
+
+    if (cache) {
+        for (i = 0; i < cache->count; i++) {
+            if (VectorCompare(cache->dest[i], dest)) {
+                level.perf.radius_cached++;
+                return cache->clear[i];
+            }
+        }
+        level.perf.radius_traces++;
+    }
+
+    trace = gi.trace(inflictor->s.origin, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
+
+    if (cache && cache->count < MAX_CANDAMAGE_TRACES) {
+        VectorCopy(dest, cache->dest[cache->count]);
+        cache->clear[cache->count] = trace.fraction == 1.0f;
+        cache->count++;
+    }
+
+    return trace.fraction == 1.0f;
+}
+
 /*
 ============
 CanDamage
 
 Returns true if the inflictor can directly damage the target.  Used for
 explosions and melee attacks.
+
+Corners are probed starting with the one nearest to the inflictor, the
+far ones are the least likely to be visible when the center isn't.
+Traces done on behalf of T_RadiusDamage are cached for its duration.
 ============
 */
 bool CanDamage(edict_t *targ, edict_t *inflictor)
 {
+    // corner numbers ordered by number of far sides
+    static const byte corners[8] = { 0, 1, 2, 4, 3, 5, 6, 7 };
     vec3_t  dest;
     trace_t trace;
-    int i;
+    int i, j, side = 0;
 
 // bmodels need special checking because their origin is 0,0,0
     if (targ->movetype == MOVETYPE_PUSH) {
@@ -47,32 +92,37 @@ bool CanDamage(edict_t *targ, edict_t *inflictor)
         return false;
     }
 
-    trace = gi.trace(inflictor->s.origin, vec3_origin, vec3_origin, targ->s.origin, inflictor, MASK_SOLID);
-    if (trace.fraction == 1.0f)
+    if (CanDamageTrace(inflictor, targ->s.origin))
         return true;
 
+    // bit set for each axis the min side is nearer to inflictor
+    for (j = 0; j < 3; j++) {
+        if (inflictor->s.origin[j] < targ->s.origin[j])
+            side |= 1 << j;
+    }
+
     if ((int)g_bugs->value < 1) {
-        const vec_t *bounds[2] = { targ->absmin, targ->absmax };
+        const vec_t *bounds[2] = { targ->absmax, targ->absmin };
 
         for (i = 0; i < 8; i++) {
-            dest[0] = bounds[(i >> 0) & 1][0];
-            dest[1] = bounds[(i >> 1) & 1][1];
-            dest[2] = bounds[(i >> 2) & 1][2];
+            j = corners[i] ^ side;
+            dest[0] = bounds[(j >> 0) & 1][0];
+            dest[1] = bounds[(j >> 1) & 1][1];
+            dest[2] = bounds[(j >> 2) & 1][2];
 
-            trace = gi.trace(inflictor->s.origin, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
-            if (trace.fraction == 1.0f)
+            if (CanDamageTrace(inflictor, dest))
                 return true;
         }
     } else {
-        static const vec_t offsets[2] = { -15.0f, 15.0f };
+        static const vec_t offsets[2] = { 15.0f, -15.0f };
 
         dest[2] = targ->s.origin[2];
         for (i = 0; i < 4; i++) {
-            dest[0] = targ->s.origin[0] + offsets[(i >> 0) & 1];
-            dest[1] = targ->s.origin[1] + offsets[(i >> 1) & 1];
+            j = i ^ side;
+            dest[0] = targ->s.origin[0] + offsets[(j >> 0) & 1];
+            dest[1] = targ->s.origin[1] + offsets[(j >> 1) & 1];
 
-            trace = gi.trace(inflictor->s.origin, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
-            if (trace.fraction == 1.0f)
+            if (CanDamageTrace(inflictor, dest))
                 return true;
         }
     }
@@ -103,11 +153,7 @@ SpawnDamage
 */
 static void SpawnDamage(int type, const vec3_t origin, const vec3_t normal)
 {
-    gi.WriteByte(svc_temp_entity);
-    gi.WriteByte(type);
-    gi.WritePosition(origin);
-    gi.WriteDir(normal);
-    gi.multicast(origin, MULTICAST_PVS);
+    G_ImpactEffect(type, origin, normal);
 }
 
 
@@ -304,6 +350,9 @@ void T_Damage(edict_t *targ, edict_t *inflictor, edict_t *attacker, const vec3_t
 
             VectorNormalize2(dir, temp);
             VectorMA(targ->velocity, push, temp, targ->velocity);
+
+            if (targ->flags & FL_SLEEPING)
+                G_WakeEntity(targ);
         }
     }
 
@@ -399,6 +448,12 @@ void T_RadiusDamage(edict_t *inflictor, edict_t *attacker, float damage, edict_t
     edict_t *ent = NULL;
     vec3_t  v;
     vec3_t  dir;
+    candamage_cache_t cache, *oldcache;
+
+    // T_Damage may cause another explosion from a different origin
+    oldcache = candamage_cache;
+    cache.count = 0;
+    level.perf.radius_events++;
 
     while ((ent = findradius(ent, inflictor->s.origin, radius)) != NULL) {
         if (ent == ignore)
@@ -412,11 +467,19 @@ void T_RadiusDamage(edict_t *inflictor, edict_t *attacker, float damage, edict_t
         points = damage - 0.5f * VectorLength(v);
         if (ent == attacker)
             points = points * 0.5f;
+
+        // zero damage only matters for client hit statistics
+        if (!ent->client && (int)points <= 0)
+            continue;
+
         if (points > 0) {
+            candamage_cache = &cache;
             if (CanDamage(ent, inflictor)) {
+                candamage_cache = oldcache;
                 VectorSubtract(ent->s.origin, inflictor->s.origin, dir);
                 T_Damage(ent, inflictor, attacker, dir, inflictor->s.origin, vec3_origin, (int)points, (int)points, DAMAGE_RADIUS, mod);
             }
+            candamage_cache = oldcache;
         }
     }
 }
@@ -675,7 +675,7 @@ void Use_PowerArmor(edict_t *ent, gitem_t *item)
 {
     if (ent->flags & FL_POWER_ARMOR) {
         ent->flags &= ~FL_POWER_ARMOR;
-        gi.sound(ent, CHAN_AUTO, gi.soundindex("misc/power2.wav"), 1, ATTN_NORM, 0);
+        gi.sound(ent, CHAN_AUTO, PowerArmorSoundIndex(), 1, ATTN_NORM, 0);
     } else {
         if (!ent->client->inventory[ITEM_CELLS]) {
             gi.cprintf(ent, PRINT_HIGH, "No cells for power armor.\n");
@@ -748,6 +748,35 @@ static void AccountItemPickup(edict_t *ent, edict_t *other)
     }
 }
 
+/*
+===============
+G_IsMajorItem
+
+Armor, weapons, powerups and megahealth placed by the map.
+===============
+*/
+bool G_IsMajorItem(edict_t *ent)
+{
+    gitem_t *item = ent->item;
+
+    if (!item)
+        return false;
+
+    if (ent->spawnflags & (DROPPED_ITEM | DROPPED_PLAYER_ITEM))
+        return false;
+
+    if (ITEM_INDEX(item) == ITEM_HEALTH)
+        return ent->style & HEALTH_TIMED;
+
+    if (item->flags & (IT_WEAPON | IT_POWERUP))
+        return true;
+
+    if (item->flags & IT_ARMOR)
+        return item->tag != ARMOR_SHARD;
+
+    return false;
+}
+
 
 /*
 ===============
@@ -774,7 +803,7 @@ void Touch_Item(edict_t *ent, edict_t *other, cplane_t *plane, csurface_t *surf)
         other->client->bonus_alpha = 0.25f;
 
         // show icon and name on status bar
-        other->client->ps.stats[STAT_PICKUP_ICON] = gi.imageindex(ent->item->icon);
+        other->client->ps.stats[STAT_PICKUP_ICON] = ItemIconIndex(ent->item);
         other->client->ps.stats[STAT_PICKUP_STRING] = CS_ITEMS + ITEM_INDEX(ent->item);
         other->client->pickup_framenum = level.framenum + 3 * HZ;
 
@@ -792,7 +821,7 @@ void Touch_Item(edict_t *ent, edict_t *other, cplane_t *plane, csurface_t *surf)
             else // (ent->count == 100)
                 gi.sound(other, CHAN_ITEM, gi.soundindex("items/m_health.wav"), 1, ATTN_NORM, 0);
         } else if (ent->item->pickup_sound) {
-            gi.sound(other, CHAN_ITEM, gi.soundindex(ent->item->pickup_sound), 1, ATTN_NORM, 0);
+            gi.sound(other, CHAN_ITEM, ItemSoundIndex(ent->item), 1, ATTN_NORM, 0);
         }
     }
 
@@ -855,7 +884,7 @@ edict_t *Drop_Item(edict_t *ent, gitem_t *item)
     if (ent->client) {
         trace_t trace;
 
-        AngleVectors(ent->client->v_angle, forward, right, NULL);
+        G_ViewVectors(ent->client, forward, right, NULL);
         VectorSet(offset, 24, 0, -16);
         G_ProjectSource(ent->s.origin, offset, forward, right, dropped->s.origin);
         trace = gi.trace(ent->s.origin, dropped->mins, dropped->maxs,
@@ -964,6 +993,42 @@ void droptofloor(edict_t *ent)
 }
 
 
+/*
+===============
+ItemIconIndex / ItemSoundIndex / PowerArmorSoundIndex
+
+Return cached configstring indices, resolving them
+for items that were never precached (given by cheats).
+===============
+*/
+int ItemIconIndex(const gitem_t *it)
+{
+    int index = ITEM_INDEX(it);
+
+    if (!level.items.icons[index] && it->icon)
+        level.items.icons[index] = gi.imageindex(it->icon);
+
+    return level.items.icons[index];
+}
+
+int ItemSoundIndex(const gitem_t *it)
+{
+    int index = ITEM_INDEX(it);
+
+    if (!level.items.sounds[index] && it->pickup_sound)
+        level.items.sounds[index] = gi.soundindex(it->pickup_sound);
+
+    return level.items.sounds[index];
+}
+
+int PowerArmorSoundIndex(void)
+{
+    if (!level.sounds.power2)
+        level.sounds.power2 = gi.soundindex("misc/power2.wav");
+
+    return level.sounds.power2;
+}
+
 /*
 ===============
 PrecacheItem
@@ -983,13 +1048,15 @@ void PrecacheItem(gitem_t *it)
         return;
 
     if (it->pickup_sound)
-        gi.soundindex(it->pickup_sound);
+        level.items.sounds[ITEM_INDEX(it)] = gi.soundindex(it->pickup_sound);
     if (it->world_model)
         gi.modelindex(it->world_model);
     if (it->view_model)
         gi.modelindex(it->view_model);
     if (it->icon)
-        gi.imageindex(it->icon);
+        level.items.icons[ITEM_INDEX(it)] = gi.imageindex(it->icon);
+    if (it->pickup == Pickup_PowerArmor)
+        PowerArmorSoundIndex();
 
     // parse everything for its ammo
     if (it->ammo && it->ammo[0]) {
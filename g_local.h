@@ -97,6 +97,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define FL_POWER_ARMOR          0x00001000  // power armor (if any) is active
 #define FL_NOCLIP_PROJECTILE    0x00002000  // projectile hack
 #define FL_MEGAHEALTH           0x00004000  // for megahealth kills tracking
+#define FL_SLEEPING             0x00008000  // toss entity stalled, physics skipped
 #define FL_ACCELERATE           0x20000000  // accelerative movement
 #define FL_HIDDEN               0x40000000  // used for banned items
 #define FL_RESPAWN              0x80000000  // used for item respawning
@@ -131,6 +132,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define MELEE_DISTANCE  80
 
 #define BODY_QUEUE_SIZE     8
+#define MAX_GIBS            128
 
 #define MAX_NETNAME     16
 #define MAX_SKINNAME    24
@@ -279,6 +281,17 @@ typedef enum {
     MOVETYPE_BOUNCE
 } movetype_t;
 
+// projectile templates, see G_SpawnProjectile
+typedef enum {
+    PROJ_BLASTER,
+    PROJ_GRENADE,
+    PROJ_HGRENADE,
+    PROJ_ROCKET,
+    PROJ_BFG,
+
+    PROJ_MAX
+} projectile_t;
+
 
 typedef struct {
     int     base_count;
@@ -381,6 +394,17 @@ typedef struct {
     char        motd[MAX_STRING_CHARS];
 
     char        dir[MAX_OSPATH]; // where variable data is stored
+
+    // player to player visibility, shared by player id view callers
+    unsigned    *viscache;      // maxclients * maxclients
+    unsigned    visgen;         // entries older than this are stale
+    int         visframenum;    // frame visgen was last advanced at
+
+    // player positions for lag compensation, LAG_FRAMES * maxclients
+    vec3_t      *lag_origins;
+    vec3_t      *lag_mins;
+    vec3_t      *lag_maxs;
+    byte        *lag_flags;
 } game_locals_t;
 
 // vote proposals
@@ -403,6 +427,7 @@ typedef struct {
 #define VF(x)       (((int)g_vote_flags->value & VF_##x) != 0)
 
 #define MAX_SPAWNS  64
+#define MAX_SPAWN_ITEMS 64
 
 #define ITB_QUAD    1
 #define ITB_INVUL   2
@@ -438,6 +463,29 @@ typedef struct {
     edict_t     *spawns[MAX_SPAWNS];
     int         numspawns;
 
+    // nearest player distances for spawn point selection
+    struct {
+        bool        valid;
+        bool        alive[MAX_CLIENTS];
+        vec3_t      origins[MAX_CLIENTS];   // where distances were computed from
+        float       dists[MAX_CLIENTS][MAX_SPAWNS];
+        float       ranges[MAX_SPAWNS];     // nearest living player distance
+        int         nearest[MAX_SPAWNS];    // client number it was measured from
+    } spawn_cache;
+
+    // line of sight between spawn points and major items, computed
+    // over several frames after map load
+    struct {
+        bool        started;
+        bool        done;
+        int         spawn;                  // next pair to trace
+        int         other;
+        int         numitems;
+        vec3_t      items[MAX_SPAWN_ITEMS];
+        uint64_t    spawns_seen[MAX_SPAWNS];    // includes self
+        uint64_t    items_seen[MAX_SPAWNS];
+    } spawn_vis;
+
     match_state_t   match_state;
     int         countdown_framenum;     // time the countdown was started
     int         activity_framenum;      // time the last client has been active
@@ -491,8 +539,15 @@ typedef struct {
         int     count;
         int     xian;
         int     makron;
+        int     power2;
     } sounds;
 
+    // item icons and pickup sounds, set by PrecacheItem
+    struct {
+        int     icons[ITEM_TOTAL];
+        int     sounds[ITEM_TOTAL];
+    } items;
+
     struct {
         int     meat;
         int     skull;
@@ -512,6 +567,71 @@ typedef struct {
 
     edict_t     *current_entity;    // entity running from G_RunFrame
     int         body_que;           // dead bodies
+
+    int         num_gibs;           // size of gib pool following body que
+    int         gib_framenum;       // frame gibs were last thrown at
+    int         gib_count;          // gibs thrown this frame
+
+    int         noclip_projectiles; // live FL_NOCLIP_PROJECTILE entities
+
+    int         spawn_hint;         // edicts below this are all in use
+
+    // projectile template indices, registered on first use
+    int         projectile_models[PROJ_MAX];
+    int         projectile_sounds[PROJ_MAX];
+
+    // performance counters, shown by "sv perf"
+    struct {
+        int     toss_slept;     // toss moves skipped for sleeping entities
+        int     gibs_thrown;
+        int     gibs_recycled;  // live gibs reused from pool
+        int     gibs_trimmed;   // gibs not thrown due to per frame budget
+        int     spawn_dists;    // player to spawn point distances computed
+        int     spawn_rescans;  // spawn point ranges searched across all players
+        int     spawn_vis_traces;   // spawn point visibility traces
+        int     viewid_traces;      // player id view visibility traces
+        int     viewid_cached;      // visibility checks answered from cache
+        int     viewid_evals;       // full id view searches
+        int     viewid_skipped;     // id view searches skipped by scheduler
+        int     scoreboard_builds;  // shared scoreboard rows rendered
+        int     scoreboard_sends;   // scoreboards sent to clients
+        int     rank_moves;         // rank order insertion sort moves
+        int     rank_strings;       // rank strings rebuilt
+        int     private_strings;    // private configstrings sent
+        int     private_unicasts;   // messages they were batched into
+        int     menu_entries;       // menu entries rendered
+        int     menu_bytes;         // menu layout bytes sent
+        int     menu_bytes_saved;   // bytes saved by coalescing menu updates
+        int     chase_views;        // chased player views computed
+        int     chase_updates;      // chasers updated from shared views
+        int     view_basis_calcs;   // view basis computations (6 trig calls each)
+        int     view_basis_cached;  // view basis lookups served from cache
+        int     pellet_shots;       // shotgun blasts fired
+        int     pellet_traces;      // traces done by shotgun blasts
+        int     pellet_damages;     // merged pellet T_Damage calls
+        int     impact_effects;     // impact temp entities queued
+        int     impact_multicasts;  // multicasts sending them
+        int     impact_bytes;       // bytes written for them
+        int     impact_dropped;     // effects over per cluster limit
+        int     antilag_rewinds;    // hitscan shots with players moved back
+        int     antilag_relinks;    // players moved back for them
+        int     radius_events;      // T_RadiusDamage calls
+        int     radius_traces;      // CanDamage traces done for them
+        int     radius_cached;      // CanDamage traces served from cache
+        int     bfg_thinks;         // BFG laser updates
+        int     bfg_candidates;     // entities near BFG balls checked
+        int     bfg_traces;         // BFG laser traces
+        int     projectile_traces;  // player vs projectile clipping traces
+        int     projectile_avoided; // clipping traces avoided
+        int     damage_events;      // player damage events recorded
+        int     damage_sums;        // per attacker, target and weapon sums
+        int     rail_shots;         // railgun shots
+        int     rail_traces;        // world traces done for them
+        int     rail_boxes;         // entity boxes crossed by them
+        int     projectile_spawns;  // projectiles spawned from templates
+        int     spawn_scans;        // edicts checked by G_Spawn
+        int     missile_moves;      // fly missile physics steps
+    } perf;
 } level_locals_t;
 
 
@@ -674,6 +794,14 @@ extern  cvar_t  *g_spawn_mode;
 extern  cvar_t  *g_team_chat;
 extern  cvar_t  *g_mute_chat;
 extern  cvar_t  *g_protection_time;
+extern  cvar_t  *g_gibs_max;
+extern  cvar_t  *g_gibs_per_frame;
+extern  cvar_t  *g_viewid_refresh;
+extern  cvar_t  *g_viewid_interval;
+extern  cvar_t  *g_merge_pellets;
+extern  cvar_t  *g_impacts_per_cluster;
+extern  cvar_t  *g_antilag;
+extern  cvar_t  *g_antilag_max;
 extern  cvar_t  *dedicated;
 
 extern  cvar_t  *sv_gravity;
@@ -765,6 +893,9 @@ bool G_FloodProtect(edict_t *ent, struct flood_s *flood,
 #define INDEX_ITEM(x) ((gitem_t *)&g_itemlist[(x)])
 
 void PrecacheItem(gitem_t *it);
+int ItemIconIndex(const gitem_t *it);
+int ItemSoundIndex(const gitem_t *it);
+int PowerArmorSoundIndex(void);
 void InitItems(void);
 void SetItemNames(void);
 gitem_t *FindItem(char *pickup_name);
@@ -781,12 +912,14 @@ int PowerArmorIndex(edict_t *ent);
 bool Add_Ammo(edict_t *ent, gitem_t *item, int count);
 void Touch_Item(edict_t *ent, edict_t *other, cplane_t *plane, csurface_t *surf);
 void G_UpdateItemBans(void);
+bool G_IsMajorItem(edict_t *ent);
 
 //
 // g_utils.c
 //
 bool    G_KillBox(edict_t *ent);
 void    G_ProjectSource(vec3_t point, vec3_t distance, vec3_t forward, vec3_t right, vec3_t result);
+void    G_ViewVectors(gclient_t *client, vec3_t forward, vec3_t right, vec3_t up);
 edict_t *G_Find(edict_t *from, size_t fieldofs, char *match);
 edict_t *findradius(edict_t *from, vec3_t org, float rad);
 edict_t *G_PickTarget(char *targetname);
@@ -804,6 +937,24 @@ void    G_ShuffleArray(void *base, size_t n);
 
 size_t  G_HighlightStr(char *dst, const char *src, size_t size);
 
+typedef struct {
+    char    *data;
+    size_t  size;
+    size_t  len;
+    bool    overflowed;
+} layout_buf_t;
+
+void    G_LayoutInit(layout_buf_t *l, char *data, size_t size);
+void    G_LayoutRewind(layout_buf_t *l, size_t len);
+void    G_LayoutCopy(layout_buf_t *l, const char *text, size_t len);
+void    G_LayoutCoord(layout_buf_t *l, const char *op, int value);
+void    G_LayoutPic(layout_buf_t *l, const char *op, const char *name);
+void    G_LayoutString(layout_buf_t *l, const char *op, const char *fmt, ...) q_printf(3, 4);
+
+void    G_InitImpacts(void);
+void    G_ImpactEffect(int type, const vec3_t origin, const vec3_t dir);
+void    G_FlushImpacts(void);
+
 #define G_Malloc(x) gi.TagMalloc(x, TAG_GAME)
 #define G_Free(x)   gi.TagFree(x)
 char    *G_CopyString(const char *in);
@@ -841,11 +992,20 @@ void T_RadiusDamage(edict_t *inflictor, edict_t *attacker, float damage, edict_t
 void ThrowHead(edict_t *self, int modelindex, int damage, int type);
 void ThrowClientHead(edict_t *self, int damage);
 void ThrowGib(edict_t *self, int modelindex, int damage, int type);
+void InitGibQue(void);
+void G_FreeGib(edict_t *gib);
 void BecomeExplosion1(edict_t *self);
 
 //
 // g_weapon.c
 //
+#define LAG_FRAMES  64      // frames of lag history, must be power of two
+
+void G_ClearLagHistory(void);
+void G_SaveLagHistory(void);
+void G_RewindPlayers(edict_t *self);
+void G_RestorePlayers(void);
+edict_t *G_SpawnProjectile(projectile_t type, edict_t *self, vec3_t start, vec3_t velocity);
 bool fire_hit(edict_t *self, vec3_t aim, int damage, int kick);
 void fire_bullet(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int hspread, int vspread, int mod);
 void fire_shotgun(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int hspread, int vspread, int count, int mod);
@@ -869,6 +1029,7 @@ void G_WriteTime(int remaining);
 void G_BeginDamage(void);
 void G_AccountDamage(edict_t *targ, edict_t *inflictor, edict_t *attacker, int points);
 void G_EndDamage(void);
+void G_FlushDamage(void);
 void G_SetDeltaAngles(edict_t *ent, vec3_t angles);
 void G_ScoreChanged(edict_t *ent);
 int G_UpdateRanks(void);
@@ -895,9 +1056,11 @@ void IntermissionEndServerFrame(edict_t *ent);
 //
 void MoveClientToIntermission(edict_t *client);
 void G_PrivateString(edict_t *ent, int index, const char *string);
+void G_FlushPrivateStrings(void);
 int G_GetPlayerIdView(edict_t *ent);
 void G_SetStats(edict_t *ent);
 int G_CalcRanks(gclient_t **ranks);
+void G_DirtyScoreboard(void);
 void DeathmatchScoreboardMessage(edict_t *ent, bool reliable);
 void HighScoresMessage(void);
 
@@ -905,6 +1068,7 @@ void HighScoresMessage(void);
 // g_phys.c
 //
 void G_RunEntity(edict_t *ent);
+void G_WakeEntity(edict_t *ent);
 
 //
 // g_main.c
@@ -924,6 +1088,7 @@ void G_CheckMatchStart(void);
 //
 void G_SpawnEntities(const char *mapname, const char *entities, const char *spawnpoint);
 void G_ResetLevel(void);
+void G_RunSpawnVis(void);
 
 //============================================================================
 
@@ -983,9 +1148,15 @@ typedef struct pmenu_entry_s {
     pmenu_select_t select;
 } pmenu_entry_t;
 
+// rendered entry: ~30 bytes of coordinates and op, the rest is text,
+// which leaves room for about 4 times the width of the menu frame
+#define MENU_ENTRY_LAYOUT   128
+
 typedef struct pmenu_s {
     int cur;
     pmenu_entry_t entries[MAX_MENU_ENTRIES];
+    unsigned dirty;     // entries to render again
+    char layout[MAX_MENU_ENTRIES][MENU_ENTRY_LAYOUT];
 } pmenu_t;
 
 typedef enum {
@@ -1113,6 +1284,10 @@ typedef struct {
         int         buttons;
     } cmd;
     char        strings[PCS_TOTAL][MAX_NETNAME]; // private configstrings
+    int         dirty_strings;      // private configstrings not yet sent
+    int         rank;               // rank strings were built for, 0 if none
+    int         ranktotal;
+    int         rankdelta;
     struct {
         int         index;
         bool        accepted;
@@ -1142,8 +1317,8 @@ struct gclient_s {
     layout_t    layout;         // set layout stat
 
     pmenu_t     menu;
-//  int         menu_framenum;
-    bool        menu_dirty;
+    int         menu_framenum;  // time menu layout was last sent
+    int         menu_dirty;     // changes since then
 
     int         ammo_index;
 
@@ -1175,6 +1350,9 @@ struct gclient_s {
     float       bonus_alpha;
     vec3_t      damage_blend;
     vec3_t      v_angle;            // aiming direction
+    vec3_t      v_forward, v_right, v_up;   // cached basis of v_angle
+    vec3_t      v_basis_angle;      // v_angle the basis was computed for
+    bool        v_basis_valid;
     float       bobtime;            // so off-ground doesn't change it
     vec3_t      oldviewangles;
     vec3_t      oldvelocity;
@@ -1211,6 +1389,8 @@ struct gclient_s {
     edict_t         *chase_target;      // player we are chasing
     chase_mode_t    chase_mode;
 
+    edict_t     *viewid_target;     // player shown by id view
+
     int         selected_item;
     int         inventory[MAX_ITEMS];
 
@@ -1371,6 +1551,8 @@ struct edict_s {
 
     // hack for proper s.old_origin updates
     vec3_t      old_origin;
+
+    int         stalled_frames; // toss frames without movement
 };
 
 //
@@ -1387,10 +1569,12 @@ void PMenu_Select(edict_t *ent);
 // g_chase.c
 //
 void ChaseEndServerFrame(edict_t *ent);
+void ChaseEndServerFrames(void);
 bool ChaseNext(edict_t *ent);
 bool ChasePrev(edict_t *ent);
 bool GetChaseTarget(edict_t *ent, chase_mode_t mode);
 void SetChaseTarget(edict_t *ent, edict_t *targ);
+int G_GetChasers(edict_t *targ, edict_t **chasers);
 void UpdateChaseTargets(chase_mode_t mode, edict_t *targ);
 
 //
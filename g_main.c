@@ -59,6 +59,14 @@ cvar_t  *g_spawn_mode;
 cvar_t  *g_team_chat;
 cvar_t  *g_mute_chat;
 cvar_t  *g_protection_time;
+cvar_t  *g_gibs_max;
+cvar_t  *g_gibs_per_frame;
+cvar_t  *g_viewid_refresh;
+cvar_t  *g_viewid_interval;
+cvar_t  *g_merge_pellets;
+cvar_t  *g_impacts_per_cluster;
+cvar_t  *g_antilag;
+cvar_t  *g_antilag_max;
 cvar_t  *g_log_stats;
 cvar_t  *g_skins_file;
 cvar_t  *g_motd_file;
@@ -183,14 +191,7 @@ static void ClientEndServerFrames(void)
     }
 
     // update chase cam after all stats and positions are calculated
-    for (i = 0, c = game.clients; i < game.maxclients; i++, c++) {
-        if (c->pers.connected <= CONN_CONNECTED) {
-            continue;
-        }
-        if (c->chase_target) {
-            ChaseEndServerFrame(c->edict);
-        }
-    }
+    ChaseEndServerFrames();
 }
 
 typedef struct {
@@ -811,8 +812,7 @@ static char *transform(load_file_t *f, int num)
 
 static void G_LoadMotd(void)
 {
-    char  *text = game.motd;
-    size_t size = sizeof(game.motd);
+    layout_buf_t lay;
 
     if (!game.dir[0] || !g_motd_file->string[0])
         return;
@@ -821,26 +821,24 @@ static void G_LoadMotd(void)
     if (!f)
         return;
 
-    size_t len = Q_strlcpy(text, "xl 8 ", size);
-    text += len;
-    size -= len;
+    G_LayoutInit(&lay, game.motd, sizeof(game.motd));
+    G_LayoutCoord(&lay, "xl", 8);
 
     for (int i = 0; i < f->nb_lines; i++) {
         char *data = transform(f, i);
         if (!*data)
             continue;
-        len = Q_snprintf(text, size, "yb %d string \"%s\"",
-                         -32 - (f->nb_lines - i - 1) * 8, data);
-        if (len >= size) {
+        size_t start = lay.len;
+        G_LayoutCoord(&lay, "yb", -32 - (f->nb_lines - i - 1) * 8);
+        G_LayoutString(&lay, "string", "%s", data);
+        if (lay.overflowed) {
+            G_LayoutRewind(&lay, start);
             gi.dprintf("Oversize motd in %s\n", f->path);
             break;
         }
-        text += len;
-        size -= len;
     }
 
-    *text = 0;
-    if (len < size)
+    if (!lay.overflowed)
         gi.dprintf("Loaded motd from %s\n", f->path);
 
     G_FreeFile(f);
@@ -1167,9 +1165,19 @@ void G_RunFrame(void)
         G_UpdateVote();
     }
 
+    // credit damage done during this frame
+    G_FlushDamage();
+
     // build the playerstate_t structures for all players
     ClientEndServerFrames();
 
+    // send private configstrings changed during this frame,
+    // including the final frags and rank at intermission
+    G_FlushPrivateStrings();
+
+    // send impact effects queued during this frame
+    G_FlushImpacts();
+
     // reset settings if no one was active for the last 5 minutes
     if (game.settings_modified && level.framenum - level.activity_framenum > 5 * 60 * HZ) {
         G_ResetSettings();
@@ -1181,6 +1189,12 @@ void G_RunFrame(void)
             VectorCopy(ent->s.origin, ent->old_origin);
     }
 
+    // record player positions for lag compensation
+    G_SaveLagHistory();
+
+    // continue spawn point analysis
+    G_RunSpawnVis();
+
     G_RunDatabase();
 
     // advance for next frame
@@ -1303,6 +1317,14 @@ static void G_Init(void)
     g_team_chat = gi.cvar("g_team_chat", "0", 0);
     g_mute_chat = gi.cvar("g_mute_chat", "0", 0);
     g_protection_time = gi.cvar("g_protection_time", "0", 0);
+    g_gibs_max = gi.cvar("g_gibs_max", "32", CVAR_LATCH);
+    g_gibs_per_frame = gi.cvar("g_gibs_per_frame", "16", 0);
+    g_viewid_refresh = gi.cvar("g_viewid_refresh", "1", 0);
+    g_viewid_interval = gi.cvar("g_viewid_interval", "1", 0);
+    g_merge_pellets = gi.cvar("g_merge_pellets", "0", 0);
+    g_impacts_per_cluster = gi.cvar("g_impacts_per_cluster", "0", 0);
+    g_antilag = gi.cvar("g_antilag", "0", 0);
+    g_antilag_max = gi.cvar("g_antilag_max", "200", 0);
     g_skins_file = gi.cvar("g_skins_file", "", CVAR_LATCH);
     g_motd_file = gi.cvar("g_motd_file", "", CVAR_LATCH);
     g_highscores_dir = gi.cvar("g_highscores_dir", "", CVAR_LATCH);
@@ -1364,6 +1386,11 @@ static void G_Init(void)
     // initialize all clients for this game
     game.maxclients = maxclients->value;
     game.clients = G_Malloc(game.maxclients * sizeof(game.clients[0]));
+    game.viscache = G_Malloc(game.maxclients * game.maxclients * sizeof(game.viscache[0]));
+    game.lag_origins = G_Malloc(LAG_FRAMES * game.maxclients * sizeof(game.lag_origins[0]));
+    game.lag_mins = G_Malloc(LAG_FRAMES * game.maxclients * sizeof(game.lag_mins[0]));
+    game.lag_maxs = G_Malloc(LAG_FRAMES * game.maxclients * sizeof(game.lag_maxs[0]));
+    game.lag_flags = G_Malloc(LAG_FRAMES * game.maxclients * sizeof(game.lag_flags[0]));
     globals.num_edicts = game.maxclients + 1;
 
     // obtain game path
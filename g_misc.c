@@ -128,6 +128,98 @@ static void gib_die(edict_t *self, edict_t *inflictor, edict_t *attacker, int da
     G_FreeEdict(self);
 }
 
+/*
+=================
+InitGibQue
+
+Gibs are purely cosmetic, so they are allocated from a fixed pool of edicts
+reserved right after the body que instead of competing with gameplay
+entities for free edicts.
+=================
+*/
+void InitGibQue(void)
+{
+    int     i;
+    edict_t *ent;
+
+    level.num_gibs = G_ClampCvar(g_gibs_max, 0, MAX_GIBS);
+    level.gib_framenum = 0;
+    level.gib_count = 0;
+    for (i = 0; i < level.num_gibs; i++) {
+        ent = G_Spawn();
+        ent->classname = "gibque";
+    }
+}
+
+/*
+=================
+G_FreeGib
+
+Returns gib to the pool. Pool entries always stay in use.
+=================
+*/
+void G_FreeGib(edict_t *gib)
+{
+    gi.unlinkentity(gib);
+
+    memset(gib, 0, sizeof(*gib));
+    G_InitEdict(gib);
+    gib->classname = "gibque";
+}
+
+/*
+=================
+AllocGib
+
+Picks a free gib from the pool, or recycles the least recently thrown one.
+Returns NULL if per frame budget is exhausted.
+=================
+*/
+static edict_t *AllocGib(void)
+{
+    edict_t *gib, *best;
+    int     i, limit;
+
+    if (!level.num_gibs)
+        return NULL;
+
+    if (level.gib_framenum != level.framenum) {
+        level.gib_framenum = level.framenum;
+        level.gib_count = 0;
+    }
+
+    limit = g_gibs_per_frame->value;
+    if (limit > 0 && level.gib_count >= limit) {
+        level.perf.gibs_trimmed++;
+        return NULL;
+    }
+
+    best = NULL;
+    gib = &g_edicts[game.maxclients + BODY_QUEUE_SIZE + 1];
+    for (i = 0; i < level.num_gibs; i++, gib++) {
+        if (!gib->s.modelindex) {
+            best = gib;
+            break;
+        }
+        if (!best || gib->timestamp < best->timestamp)
+            best = gib;
+    }
+
+    if (best->s.modelindex) {
+        // don't interpolate recycled gib from it's old position
+        G_FreeGib(best);
+        best->s.event = EV_OTHER_TELEPORT;
+        level.perf.gibs_recycled++;
+    }
+
+    level.gib_count++;
+    level.perf.gibs_thrown++;
+
+    best->classname = "gib";
+    best->timestamp = level.framenum;
+    return best;
+}
+
 void ThrowGib(edict_t *self, int modelindex, int damage, int type)
 {
     edict_t *gib;
@@ -136,7 +228,9 @@ void ThrowGib(edict_t *self, int modelindex, int damage, int type)
     vec3_t  size;
     float   vscale;
 
-    gib = G_Spawn();
+    gib = AllocGib();
+    if (!gib)
+        return;
 
     VectorScale(self->size, 0.5f, size);
     VectorAdd(self->absmin, size, origin);
@@ -109,6 +109,19 @@ static bool SV_RunThink(edict_t *ent)
     return false;
 }
 
+/*
+=============
+G_WakeEntity
+
+Makes sleeping toss entity run physics again
+=============
+*/
+void G_WakeEntity(edict_t *ent)
+{
+    ent->flags &= ~FL_SLEEPING;
+    ent->stalled_frames = 0;
+}
+
 /*
 ==================
 SV_Impact
@@ -126,6 +139,9 @@ static void SV_Impact(edict_t *e1, trace_t *trace)
     if (e1->touch && e1->solid != SOLID_NOT)
         e1->touch(e1, e2, &trace->plane, trace->surface);
 
+    if (e2->flags & FL_SLEEPING)
+        G_WakeEntity(e2);
+
     if (e2->touch && e2->solid != SOLID_NOT)
         e2->touch(e2, e1, NULL, NULL);
 }
@@ -244,6 +260,38 @@ static pushed_t pushed[MAX_EDICTS], *pushed_p;
 
 static edict_t  *obstacle;
 
+static edict_t  *pushcheck[MAX_EDICTS * 2];
+
+static int PushCheckCmp(const void *p1, const void *p2)
+{
+    edict_t *a = *(edict_t **)p1;
+    edict_t *b = *(edict_t **)p2;
+
+    return (a > b) - (a < b);
+}
+
+/*
+============
+SV_PushCandidates
+
+Returns linked entities that can possibly be affected by the pusher sweeping
+from mins/maxs of it's original position to the final one. Riders standing on
+the pusher always touch it's original bounds, so they are included too.
+
+List is sorted by entity number to preserve original push order.
+============
+*/
+static int SV_PushCandidates(vec3_t mins, vec3_t maxs)
+{
+    int     num;
+
+    num = gi.BoxEdicts(mins, maxs, pushcheck, MAX_EDICTS, AREA_SOLID);
+    num += gi.BoxEdicts(mins, maxs, pushcheck + num, MAX_EDICTS, AREA_TRIGGERS);
+
+    qsort(pushcheck, num, sizeof(pushcheck[0]), PushCheckCmp);
+    return num;
+}
+
 /*
 ============
 SV_Push
@@ -254,9 +302,9 @@ otherwise riders would continue to slide.
 */
 static bool SV_Push(edict_t *pusher, vec3_t move, vec3_t amove)
 {
-    int         i, e;
+    int         i, e, num;
     edict_t     *check, *block;
-    vec3_t      mins, maxs;
+    vec3_t      mins, maxs, boxmins, boxmaxs;
     pushed_t    *p;
     vec3_t      org, org2, move2, forward, right, up;
 
@@ -274,6 +322,12 @@ static bool SV_Push(edict_t *pusher, vec3_t move, vec3_t amove)
         maxs[i] = pusher->absmax[i] + move[i];
     }
 
+    // find the swept bounding box for candidate selection
+    for (i = 0; i < 3; i++) {
+        boxmins[i] = min(pusher->absmin[i], mins[i]);
+        boxmaxs[i] = max(pusher->absmax[i], maxs[i]);
+    }
+
 // we need this for pushing things later
     VectorSubtract(vec3_origin, amove, org);
     AngleVectors(org, forward, right, up);
@@ -294,8 +348,9 @@ static bool SV_Push(edict_t *pusher, vec3_t move, vec3_t amove)
     gi.linkentity(pusher);
 
 // see if any solid entities are inside the final position
-    check = g_edicts + 1;
-    for (e = 1; e < globals.num_edicts; e++, check++) {
+    num = SV_PushCandidates(boxmins, boxmaxs);
+    for (e = 0; e < num; e++) {
+        check = pushcheck[e];
         if (!check->inuse)
             continue;
         if (check->movetype == MOVETYPE_PUSH
@@ -359,6 +414,7 @@ static bool SV_Push(edict_t *pusher, vec3_t move, vec3_t amove)
             if (!block) {
                 // pushed ok
                 gi.linkentity(check);
+                G_WakeEntity(check);
                 // impact?
                 continue;
             }
@@ -506,11 +562,36 @@ TOSS / BOUNCE
 ==============================================================================
 */
 
+/*
+=============
+SV_CheckWaterTransition
+=============
+*/
+static void SV_CheckWaterTransition(edict_t *ent, const vec3_t old_origin)
+{
+    bool    wasinwater;
+    bool    isinwater;
+
+    wasinwater = (ent->watertype & MASK_WATER);
+    ent->watertype = gi.pointcontents(ent->s.origin);
+    isinwater = (ent->watertype & MASK_WATER);
+    ent->waterlevel = isinwater;
+
+    if (!wasinwater && isinwater)
+        gi.positioned_sound(old_origin, g_edicts, CHAN_AUTO, gi.soundindex("misc/h2ohit1.wav"), 1, 1, 0);
+    else if (wasinwater && !isinwater)
+        gi.positioned_sound(ent->s.origin, g_edicts, CHAN_AUTO, gi.soundindex("misc/h2ohit1.wav"), 1, 1, 0);
+}
+
 /*
 =============
 SV_Physics_Toss
 
 Toss, bounce, and fly movement.  When onground, do nothing.
+
+Entities that can't make any progress against the world for a few frames
+(wedged between brushes, stuck on steep slopes or inside solid) are put to
+sleep until touched, pushed or damaged.
 =============
 */
 static void SV_Physics_Toss(edict_t *ent)
@@ -519,8 +600,6 @@ static void SV_Physics_Toss(edict_t *ent)
     vec3_t      move;
     float       backoff;
     edict_t     *slave;
-    bool        wasinwater;
-    bool        isinwater;
     vec3_t      old_origin;
 
 // regular thinking
@@ -544,6 +623,12 @@ static void SV_Physics_Toss(edict_t *ent)
     if (ent->groundentity)
         return;
 
+// if sleeping, return without moving
+    if (ent->flags & FL_SLEEPING) {
+        level.perf.toss_slept++;
+        return;
+    }
+
     VectorCopy(ent->s.origin, old_origin);
 
     SV_CheckVelocity(ent);
@@ -584,16 +669,19 @@ static void SV_Physics_Toss(edict_t *ent)
 //          ent->touch (ent, trace.ent, &trace.plane, trace.surface);
     }
 
-// check for water transition
-    wasinwater = (ent->watertype & MASK_WATER);
-    ent->watertype = gi.pointcontents(ent->s.origin);
-    isinwater = (ent->watertype & MASK_WATER);
-    ent->waterlevel = isinwater;
+// check for stalling against the world
+    if (trace.fraction < 1 && trace.ent == world && !ent->groundentity
+        && !ent->prethink && VectorCompare(ent->s.origin, old_origin)) {
+        if (++ent->stalled_frames >= 0.2f * HZ) {
+            ent->flags |= FL_SLEEPING;
+            VectorClear(ent->velocity);
+        }
+    } else {
+        ent->stalled_frames = 0;
+    }
 
-    if (!wasinwater && isinwater)
-        gi.positioned_sound(old_origin, g_edicts, CHAN_AUTO, gi.soundindex("misc/h2ohit1.wav"), 1, 1, 0);
-    else if (wasinwater && !isinwater)
-        gi.positioned_sound(ent->s.origin, g_edicts, CHAN_AUTO, gi.soundindex("misc/h2ohit1.wav"), 1, 1, 0);
+// check for water transition
+    SV_CheckWaterTransition(ent, old_origin);
 
 // move teamslaves
     for (slave = ent->teamchain; slave; slave = slave->teamchain) {
@@ -602,6 +690,61 @@ static void SV_Physics_Toss(edict_t *ent)
     }
 }
 
+/*
+=============
+SV_Physics_FlyMissile
+
+Straight line projectile movement. This is SV_Physics_Toss without the
+parts missiles never use: gravity, bouncing, angular velocity, sleeping
+and team slaves. Missiles are freed by their touch function on impact,
+so clipping velocity only matters for the rare one that survives it.
+=============
+*/
+static void SV_Physics_FlyMissile(edict_t *ent)
+{
+    trace_t     trace;
+    vec3_t      move;
+    vec3_t      old_origin;
+
+// regular thinking
+    SV_RunThink(ent);
+    if (!ent->inuse)
+        return;
+
+    level.perf.missile_moves++;
+
+// check for the groundentity going away
+    if (ent->groundentity) {
+        if (ent->groundentity->inuse)
+            return;
+        ent->groundentity = NULL;
+    }
+
+    VectorCopy(ent->s.origin, old_origin);
+
+    SV_CheckVelocity(ent);
+
+// move origin
+    VectorScale(ent->velocity, FRAMETIME, move);
+    trace = SV_PushEntity(ent, move);
+    if (!ent->inuse)
+        return;
+
+    if (trace.fraction < 1) {
+        ClipVelocity(ent->velocity, trace.plane.normal, ent->velocity, 1);
+
+        // stop if on ground
+        if (trace.plane.normal[2] > 0.7f) {
+            ent->groundentity = trace.ent;
+            ent->groundentity_linkcount = trace.ent->linkcount;
+            VectorClear(ent->velocity);
+        }
+    }
+
+// check for water transition
+    SV_CheckWaterTransition(ent, old_origin);
+}
+
 //============================================================================
 /*
 ================
@@ -628,9 +771,11 @@ void G_RunEntity(edict_t *ent)
     case MOVETYPE_TOSS:
     case MOVETYPE_BOUNCE:
     case MOVETYPE_FLY:
-    case MOVETYPE_FLYMISSILE:
         SV_Physics_Toss(ent);
         break;
+    case MOVETYPE_FLYMISSILE:
+        SV_Physics_FlyMissile(ent);
+        break;
     default:
         gi.error("%s: bad movetype %i", __func__, ent->movetype);
     }
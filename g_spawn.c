@@ -543,6 +543,7 @@ void G_SpawnEntities(const char *mapname, const char *entities, const char *spaw
     char        *token;
     char        playerskin[MAX_QPATH];
 
+    G_FlushDamage();
     G_LogClients();
 
     gi.FreeTags(TAG_LEVEL);
@@ -581,6 +582,8 @@ void G_SpawnEntities(const char *mapname, const char *entities, const char *spaw
         gi.configstring(CS_PLAYERNAMES + i, client->pers.netname);
     }
 
+    G_DirtyScoreboard();
+
     // parse worldspawn
     token = COM_Parse(&entities);
     if (!entities)
@@ -610,6 +613,96 @@ void G_SpawnEntities(const char *mapname, const char *entities, const char *spaw
     gi.dprintf("%d spawn points\n", level.numspawns);
 }
 
+#define SPAWN_VIS_TRACES    128     // max traces per frame
+#define SPAWN_VIS_HEIGHT    24      // approximate eye height
+
+static void SpawnVisItems(void)
+{
+    edict_t *ent;
+    int i;
+
+    for (i = game.maxclients + 1; i < globals.num_edicts; i++) {
+        ent = &g_edicts[i];
+        if (!ent->inuse || !G_IsMajorItem(ent))
+            continue;
+        if (level.spawn_vis.numitems == MAX_SPAWN_ITEMS)
+            break;
+        VectorCopy(ent->s.origin, level.spawn_vis.items[level.spawn_vis.numitems]);
+        level.spawn_vis.numitems++;
+    }
+}
+
+/*
+=================
+G_RunSpawnVis
+
+Traces line of sight from each spawn point to every other spawn point and
+major item. Done incrementally with a per frame trace budget, starting once
+items have dropped to floor.
+=================
+*/
+void G_RunSpawnVis(void)
+{
+    int budget = SPAWN_VIS_TRACES;
+    vec3_t start, end;
+    trace_t tr;
+    int i, j;
+
+    if (level.spawn_vis.done)
+        return;
+
+    if (!level.spawn_vis.started) {
+        if (level.framenum < 3)
+            return;
+        SpawnVisItems();
+        for (i = 0; i < level.numspawns; i++)
+            level.spawn_vis.spawns_seen[i] = 1ULL << i;
+        level.spawn_vis.spawn = 0;
+        level.spawn_vis.other = 1;
+        level.spawn_vis.started = true;
+    }
+
+    while (level.spawn_vis.spawn < level.numspawns) {
+        i = level.spawn_vis.spawn;
+        j = level.spawn_vis.other;
+        if (j == level.numspawns + level.spawn_vis.numitems) {
+            level.spawn_vis.spawn = i + 1;
+            level.spawn_vis.other = i + 2;
+            continue;
+        }
+        if (!budget)
+            return;
+
+        VectorCopy(level.spawns[i]->s.origin, start);
+        if (j < level.numspawns)
+            VectorCopy(level.spawns[j]->s.origin, end);
+        else
+            VectorCopy(level.spawn_vis.items[j - level.numspawns], end);
+        start[2] += SPAWN_VIS_HEIGHT;
+        end[2] += SPAWN_VIS_HEIGHT;
+
+        if (gi.inPVS(start, end)) {
+            tr = gi.trace(start, NULL, NULL, end, NULL, MASK_OPAQUE);
+            level.perf.spawn_vis_traces++;
+            budget--;
+            if (tr.fraction == 1.0f) {
+                if (j < level.numspawns) {
+                    level.spawn_vis.spawns_seen[i] |= 1ULL << j;
+                    level.spawn_vis.spawns_seen[j] |= 1ULL << i;
+                } else {
+                    level.spawn_vis.items_seen[i] |= 1ULL << (j - level.numspawns);
+                }
+            }
+        }
+
+        level.spawn_vis.other = j + 1;
+    }
+
+    gi.dprintf("%d spawn points, %d items analyzed\n",
+               level.numspawns, level.spawn_vis.numitems);
+    level.spawn_vis.done = true;
+}
+
 void G_ResetLevel(void)
 {
     gclient_t *client;
@@ -619,6 +712,7 @@ void G_ResetLevel(void)
 
     gi.FreeTags(TAG_LEVEL);
 
+    G_FlushDamage();
     G_LogClients();
 
     G_FinishVote();
@@ -633,6 +727,8 @@ void G_ResetLevel(void)
     level.record = 0;
     level.players_in = level.players_out = 0;
     level.match_state = (int)g_warmup->value ? MS_WARMUP : MS_PLAYING;
+    memset(&level.perf, 0, sizeof(level.perf));
+    level.spawn_cache.valid = false;
 
     // free all edicts
     for (i = 0; i < globals.num_edicts; i++) {
@@ -642,8 +738,12 @@ void G_ResetLevel(void)
         }
     }
     globals.num_edicts = game.maxclients + 1;
+    level.spawn_hint = 0;
 
     InitBodyQue();
+    InitGibQue();
+    G_InitImpacts();
+    G_ClearLagHistory();
 
     // respawn all edicts
     G_ParseString();
@@ -654,6 +754,8 @@ void G_ResetLevel(void)
     count = 0;
     for (i = 0; i < game.maxclients; i++) {
         client = &game.clients[i];
+        // level.framenum starts over
+        client->menu_framenum = 0;
         if (!client->pers.connected) {
             continue;
         }
@@ -847,6 +949,15 @@ void SP_worldspawn(edict_t *ent)
     // reserve some spots for dead player bodies for coop / deathmatch
     InitBodyQue();
 
+    // reserve some spots for gibs so they never starve other entities
+    InitGibQue();
+
+    // cluster probe for impact effects
+    G_InitImpacts();
+
+    // player positions from the last map are useless
+    G_ClearLagHistory();
+
     // set configstrings for items
     SetItemNames();
 
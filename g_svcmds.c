@@ -40,6 +40,7 @@ static void Svcmd_Help_f(void)
         "highscores Show the best results on map\n"
         "stats      Show player statistics\n"
         "settings   Show game settings\n"
+        "perf       Show performance counters\n"
         "help       Show this help message\n"
       );
 }
@@ -100,6 +101,84 @@ static void Svcmd_MapQueue_f(void)
     }
 }
 
+#define PERF(x)     { #x, q_offsetof(level_locals_t, perf.x) }
+
+static const struct {
+    const char  *name;
+    size_t      ofs;
+} perfcounters[] = {
+    PERF(toss_slept),
+    PERF(gibs_thrown),
+    PERF(gibs_recycled),
+    PERF(gibs_trimmed),
+    PERF(spawn_dists),
+    PERF(spawn_rescans),
+    PERF(spawn_vis_traces),
+    PERF(viewid_traces),
+    PERF(viewid_cached),
+    PERF(viewid_evals),
+    PERF(viewid_skipped),
+    PERF(scoreboard_builds),
+    PERF(scoreboard_sends),
+    PERF(rank_moves),
+    PERF(rank_strings),
+    PERF(private_strings),
+    PERF(private_unicasts),
+    PERF(menu_entries),
+    PERF(menu_bytes),
+    PERF(menu_bytes_saved),
+    PERF(chase_views),
+    PERF(chase_updates),
+    PERF(view_basis_calcs),
+    PERF(view_basis_cached),
+    PERF(pellet_shots),
+    PERF(pellet_traces),
+    PERF(pellet_damages),
+    PERF(impact_effects),
+    PERF(impact_multicasts),
+    PERF(impact_bytes),
+    PERF(impact_dropped),
+    PERF(antilag_rewinds),
+    PERF(antilag_relinks),
+    PERF(radius_events),
+    PERF(radius_traces),
+    PERF(radius_cached),
+    PERF(bfg_thinks),
+    PERF(bfg_candidates),
+    PERF(bfg_traces),
+    PERF(projectile_traces),
+    PERF(projectile_avoided),
+    PERF(damage_events),
+    PERF(damage_sums),
+    PERF(rail_shots),
+    PERF(rail_traces),
+    PERF(rail_boxes),
+    PERF(projectile_spawns),
+    PERF(spawn_scans),
+    PERF(missile_moves),
+};
+
+static void Svcmd_Perf_f(void)
+{
+    int frames = max(level.framenum, 1);
+    int i, count;
+
+    Com_Printf("counter                  total  per frame\n"
+               "-------------------- ---------- ---------\n");
+    for (i = 0; i < q_countof(perfcounters); i++) {
+        count = *(int *)((byte *)&level + perfcounters[i].ofs);
+        Com_Printf("%-20s %10d %9.2f\n", perfcounters[i].name,
+                   count, (float)count / frames);
+    }
+
+    // estimate from average cost of a full id view search
+    if (level.perf.viewid_evals) {
+        Com_Printf("id view traces saved: %.1f per second (estimated)\n",
+                   (float)level.perf.viewid_traces / level.perf.viewid_evals *
+                   level.perf.viewid_skipped * HZ / frames);
+    }
+}
+
 /*
 =================
 ServerCommand
@@ -147,6 +226,8 @@ void G_ServerCommand(void)
         Cmd_Stats_f(NULL, true);
     else if (!strcmp(cmd, "settings") || !strcmp(cmd, "matchinfo"))
         Cmd_Settings_f(NULL);
+    else if (!strcmp(cmd, "perf"))
+        Svcmd_Perf_f();
     else
         Com_Printf("Unknown server command \"%s\". Try \"%s help\".\n", cmd, gi.argv(0));
 }
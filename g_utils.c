@@ -29,6 +29,34 @@ void G_ProjectSource(vec3_t point, vec3_t distance, vec3_t forward, vec3_t right
     result[2] = point[2] + forward[2] * distance[0] + right[2] * distance[1] + distance[2];
 }
 
+/*
+=============
+G_ViewVectors
+
+Same as AngleVectors on client->v_angle, but the basis is cached and only
+recomputed when v_angle has changed since the last call. Any of forward,
+right and up may be NULL.
+=============
+*/
+void G_ViewVectors(gclient_t *client, vec3_t forward, vec3_t right, vec3_t up)
+{
+    if (!client->v_basis_valid || !VectorCompare(client->v_angle, client->v_basis_angle)) {
+        AngleVectors(client->v_angle, client->v_forward, client->v_right, client->v_up);
+        VectorCopy(client->v_angle, client->v_basis_angle);
+        client->v_basis_valid = true;
+        level.perf.view_basis_calcs++;
+    } else {
+        level.perf.view_basis_cached++;
+    }
+
+    if (forward)
+        VectorCopy(client->v_forward, forward);
+    if (right)
+        VectorCopy(client->v_right, right);
+    if (up)
+        VectorCopy(client->v_up, up);
+}
+
 
 /*
 =============
@@ -340,6 +368,10 @@ Try to avoid reusing an entity that was recently freed, because it
 can cause the client to think the entity morphed into something else
 instead of being removed and recreated, which can cause interpolated
 angles and bad trails.
+
+Search starts at level.spawn_hint, below which all edicts are known to
+be in use. The hint advances past the leading run of used edicts and
+is moved back by G_FreeEdict.
 =================
 */
 edict_t *G_Spawn(void)
@@ -347,11 +379,19 @@ edict_t *G_Spawn(void)
     int         i;
     edict_t     *e;
 
-    e = &g_edicts[game.maxclients + 1];
-    for (i = game.maxclients + 1; i < globals.num_edicts; i++, e++) {
+    i = max(level.spawn_hint, game.maxclients + 1);
+    for (e = &g_edicts[i]; i < globals.num_edicts; i++, e++) {
+        level.perf.spawn_scans++;
+        if (e->inuse) {
+            if (level.spawn_hint == i)
+                level.spawn_hint = i + 1;
+            continue;
+        }
         // the first couple seconds of server time can involve a lot of
         // freeing and allocating, so relax the replacement policy
-        if (!e->inuse && (e->freetime < 2 || level.time - e->freetime > 0.5f)) {
+        if (e->freetime < 2 || level.time - e->freetime > 0.5f) {
+            if (level.spawn_hint == i)
+                level.spawn_hint = i + 1;
             G_InitEdict(e);
             return e;
         }
@@ -360,6 +400,8 @@ edict_t *G_Spawn(void)
     if (i == game.maxentities)
         gi.error("ED_Alloc: no free edicts");
 
+    if (level.spawn_hint == i)
+        level.spawn_hint = i + 1;
     globals.num_edicts++;
     G_InitEdict(e);
     return e;
@@ -381,6 +423,17 @@ void G_FreeEdict(edict_t *ed)
         return;
     }
 
+    if ((ed - g_edicts) <= (maxclients->value + BODY_QUEUE_SIZE + level.num_gibs)) {
+        G_FreeGib(ed);
+        return;
+    }
+
+    if (ed->flags & FL_NOCLIP_PROJECTILE)
+        level.noclip_projectiles--;
+
+    if (level.spawn_hint > ed - g_edicts)
+        level.spawn_hint = ed - g_edicts;
+
     memset(ed, 0, sizeof(*ed));
     ed->classname = "freed";
     ed->freetime = level.time;
@@ -481,6 +534,264 @@ size_t G_HighlightStr(char *dst, const char *src, size_t size)
 /*
 ==============================================================================
 
+Layout writer
+
+Builds layout strings directly into the destination buffer. Each op is
+bounds checked once; once an op doesn't fit, it and all following ops are
+dropped. Callers that need whole rows can rewind to a saved length.
+
+==============================================================================
+*/
+
+void G_LayoutInit(layout_buf_t *l, char *data, size_t size)
+{
+    l->data = data;
+    l->size = size;
+    l->len = 0;
+    l->overflowed = false;
+    data[0] = 0;
+}
+
+void G_LayoutRewind(layout_buf_t *l, size_t len)
+{
+    l->len = len;
+    l->data[len] = 0;
+}
+
+// appends text as is, e.g. a cached prefix
+void G_LayoutCopy(layout_buf_t *l, const char *text, size_t len)
+{
+    if (l->overflowed || len >= l->size - l->len) {
+        l->overflowed = true;
+        return;
+    }
+
+    memcpy(l->data + l->len, text, len);
+    l->len += len;
+    l->data[l->len] = 0;
+}
+
+// coordinate ops: xl, xr, xv, yt, yb, yv
+void G_LayoutCoord(layout_buf_t *l, const char *op, int value)
+{
+    char        digits[16];
+    char        *p;
+    unsigned    v;
+    size_t      n;
+
+    v = value < 0 ? -(unsigned)value : value;
+    n = 0;
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    if (value < 0)
+        digits[n++] = '-';
+
+    // 2 letter op, 2 spaces
+    if (l->overflowed || n + 4 >= l->size - l->len) {
+        l->overflowed = true;
+        return;
+    }
+
+    p = l->data + l->len;
+    *p++ = op[0];
+    *p++ = op[1];
+    *p++ = ' ';
+    while (n)
+        *p++ = digits[--n];
+    *p++ = ' ';
+    *p = 0;
+    l->len = p - l->data;
+}
+
+// pic, picn
+void G_LayoutPic(layout_buf_t *l, const char *op, const char *name)
+{
+    size_t oplen = strlen(op);
+    size_t len = strlen(name);
+    char *p;
+
+    if (l->overflowed || oplen + len + 2 >= l->size - l->len) {
+        l->overflowed = true;
+        return;
+    }
+
+    p = l->data + l->len;
+    memcpy(p, op, oplen);
+    p += oplen;
+    *p++ = ' ';
+    memcpy(p, name, len);
+    p += len;
+    *p++ = ' ';
+    *p = 0;
+    l->len = p - l->data;
+}
+
+// string, string2, cstring, cstring2 with formatted text
+void G_LayoutString(layout_buf_t *l, const char *op, const char *fmt, ...)
+{
+    va_list argptr;
+    size_t  oplen = strlen(op);
+    size_t  avail, len;
+    char    *p;
+
+    // op, space and quotes
+    if (l->overflowed || oplen + 3 >= l->size - l->len) {
+        l->overflowed = true;
+        return;
+    }
+
+    p = l->data + l->len;
+    avail = l->size - l->len - oplen - 3;
+
+    va_start(argptr, fmt);
+    len = Q_vsnprintf(p + oplen + 2, avail, fmt, argptr);
+    va_end(argptr);
+
+    if (len >= avail) {
+        l->overflowed = true;
+        *p = 0;
+        return;
+    }
+
+    memcpy(p, op, oplen);
+    p[oplen] = ' ';
+    p[oplen + 1] = '"';
+    p[oplen + 2 + len] = '"';
+    p[oplen + 3 + len] = 0;
+    l->len += oplen + 3 + len;
+}
+
+/*
+==============================================================================
+
+Impact effects
+
+Point temp entities (bullet puffs, sparks, blood) are queued during the
+frame and sent at the end of it. Effects located in the same PVS cluster
+are reachable by the same set of clients, so each cluster gets a single
+multicast carrying all of its effects. The cluster of a point is found by
+linking a reserved non-solid probe edict there.
+
+==============================================================================
+*/
+
+#define MAX_IMPACTS     256
+
+typedef struct {
+    byte    type;
+    bool    sent;
+    int     cluster;    // -1 if not known, sent alone
+    int     area;
+    vec3_t  origin;
+    vec3_t  dir;
+} impact_t;
+
+static impact_t impacts[MAX_IMPACTS];
+static int      numimpacts;
+static edict_t  *impact_probe;
+
+void G_InitImpacts(void)
+{
+    impact_probe = G_Spawn();
+    impact_probe->classname = "impactprobe";
+    impact_probe->svflags = SVF_NOCLIENT;
+    impact_probe->solid = SOLID_NOT;
+    numimpacts = 0;
+}
+
+static void WriteImpact(const impact_t *fx)
+{
+    gi.WriteByte(svc_temp_entity);
+    gi.WriteByte(fx->type);
+    gi.WritePosition(fx->origin);
+    gi.WriteDir(fx->dir);
+    level.perf.impact_bytes += 9;   // svc, type, position, dir
+}
+
+/*
+=================
+G_ImpactEffect
+
+Queues point temp entity with direction to be sent at the end of frame.
+=================
+*/
+void G_ImpactEffect(int type, const vec3_t origin, const vec3_t dir)
+{
+    impact_t *fx;
+
+    if (numimpacts == MAX_IMPACTS) {
+        G_FlushImpacts();
+    }
+
+    fx = &impacts[numimpacts++];
+    fx->type = type;
+    fx->sent = false;
+    VectorCopy(origin, fx->origin);
+    VectorCopy(dir, fx->dir);
+
+    VectorCopy(origin, impact_probe->s.origin);
+    gi.linkentity(impact_probe);
+    if (impact_probe->num_clusters == 1) {
+        fx->cluster = impact_probe->clusternums[0];
+        fx->area = impact_probe->areanum;
+    } else {
+        fx->cluster = -1;
+    }
+    gi.unlinkentity(impact_probe);
+
+    level.perf.impact_effects++;
+}
+
+/*
+=================
+G_FlushImpacts
+
+Sends all queued effects, one multicast per cluster. At most
+g_impacts_per_cluster effects are sent per cluster, the rest are dropped.
+=================
+*/
+void G_FlushImpacts(void)
+{
+    impact_t *fx, *other;
+    int i, j, count, limit;
+
+    limit = max(g_impacts_per_cluster->value, 0);
+
+    for (i = 0, fx = impacts; i < numimpacts; i++, fx++) {
+        if (fx->sent) {
+            continue;
+        }
+
+        WriteImpact(fx);
+        count = 1;
+
+        if (fx->cluster != -1) {
+            for (j = i + 1, other = fx + 1; j < numimpacts; j++, other++) {
+                if (other->sent || other->cluster != fx->cluster || other->area != fx->area) {
+                    continue;
+                }
+                other->sent = true;
+                if (limit && count == limit) {
+                    level.perf.impact_dropped++;
+                    continue;
+                }
+                WriteImpact(other);
+                count++;
+            }
+        }
+
+        gi.multicast(fx->origin, MULTICAST_PVS);
+        level.perf.impact_multicasts++;
+    }
+
+    numimpacts = 0;
+}
+
+/*
+==============================================================================
+
 Kill box
 
 ==============================================================================
@@ -19,128 +19,410 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 #include "g_local.h"
 
+/*
+==============================================================================
+
+Lag compensation
+
+Origins and bounds of all solid players are recorded at the end of every
+server frame. Before a hitscan weapon traces, other players are moved back
+to where the shooter saw them, roughly client->ping milliseconds ago, and
+moved forward again once the shot is done.
+
+==============================================================================
+*/
+
+#define LAG_TELEPORT    128     // don't interpolate across moves longer than this
+
+#define LAG_VALID       1
+#define LAG_TELEPORTED  2       // teleported or respawned during this frame
+
+static int      lag_framenums[LAG_FRAMES];
+
+static struct {
+    edict_t     *ent;
+    vec3_t      origin, mins, maxs;     // real position
+    vec3_t      rewound;                // position moved to
+    int         linkcount;              // after being moved
+} lag_saved[MAX_CLIENTS];
+
+static int      lag_numsaved;
+
+void G_ClearLagHistory(void)
+{
+    int i;
+
+    for (i = 0; i < LAG_FRAMES; i++) {
+        lag_framenums[i] = -1;
+    }
+    lag_numsaved = 0;
+}
+
+/*
+=================
+G_SaveLagHistory
+
+Called at the end of each server frame.
+=================
+*/
+void G_SaveLagHistory(void)
+{
+    int slot = level.framenum & (LAG_FRAMES - 1);
+    int ofs = slot * game.maxclients;
+    edict_t *ent;
+    int i;
+
+    if (!g_antilag->value) {
+        return;
+    }
+
+    for (i = 0; i < game.maxclients; i++) {
+        ent = &g_edicts[i + 1];
+        if (!ent->inuse || ent->solid == SOLID_NOT) {
+            game.lag_flags[ofs + i] = 0;
+            continue;
+        }
+        VectorCopy(ent->s.origin, game.lag_origins[ofs + i]);
+        VectorCopy(ent->mins, game.lag_mins[ofs + i]);
+        VectorCopy(ent->maxs, game.lag_maxs[ofs + i]);
+        game.lag_flags[ofs + i] = LAG_VALID;
+        if (ent->s.event == EV_PLAYER_TELEPORT)
+            game.lag_flags[ofs + i] |= LAG_TELEPORTED;
+    }
+
+    lag_framenums[slot] = level.framenum;
+}
+
+// returns true if player teleported after given frame
+static bool LagTeleported(int num, int frame)
+{
+    while (++frame < level.framenum) {
+        if (game.lag_flags[(frame & (LAG_FRAMES - 1)) * game.maxclients + num] & LAG_TELEPORTED)
+            return true;
+    }
+    return g_edicts[num + 1].s.event == EV_PLAYER_TELEPORT;
+}
+
+/*
+=================
+G_RewindPlayers
+
+Moves all players other than shooter back in time. Must be paired with
+G_RestorePlayers.
+=================
+*/
+void G_RewindPlayers(edict_t *self)
+{
+    int frame, a, b, i, ms;
+    float frac;
+    edict_t *ent;
+    vec3_t origin, mins, maxs, delta;
+
+    lag_numsaved = 0;
+
+    if (!g_antilag->value || !self->client) {
+        return;
+    }
+
+    ms = self->client->ping;
+    clamp(ms, 0, (int)g_antilag_max->value);
+    if (!ms) {
+        return;
+    }
+
+    // view time of shooter, in frames before the last saved one
+    frac = (float)ms * HZ / 1000;
+    frame = (int)frac;
+    frac -= frame;
+    frame = level.framenum - 1 - frame;
+    if (frame < 1 || level.framenum - frame >= LAG_FRAMES) {
+        return;
+    }
+
+    // interpolate between frames a (older) and b
+    a = frame - 1;
+    b = frame;
+    frac = 1 - frac;
+    if (lag_framenums[a & (LAG_FRAMES - 1)] != a ||
+        lag_framenums[b & (LAG_FRAMES - 1)] != b) {
+        return;
+    }
+    a = (a & (LAG_FRAMES - 1)) * game.maxclients;
+    b = (b & (LAG_FRAMES - 1)) * game.maxclients;
+
+    for (i = 0; i < game.maxclients; i++) {
+        ent = &g_edicts[i + 1];
+        if (ent == self || !ent->inuse || ent->solid == SOLID_NOT) {
+            continue;
+        }
+        if (!game.lag_flags[b + i] || LagTeleported(i, frame)) {
+            continue;
+        }
+
+        VectorCopy(game.lag_origins[b + i], origin);
+        VectorCopy(game.lag_mins[b + i], mins);
+        VectorCopy(game.lag_maxs[b + i], maxs);
+        if (game.lag_flags[a + i] && !(game.lag_flags[b + i] & LAG_TELEPORTED)) {
+            VectorSubtract(origin, game.lag_origins[a + i], delta);
+            if (VectorLength(delta) < LAG_TELEPORT) {
+                VectorMA(game.lag_origins[a + i], frac, delta, origin);
+            }
+        }
+
+        // don't relink players that haven't moved
+        if (VectorCompare(origin, ent->s.origin) &&
+            VectorCompare(mins, ent->mins) && VectorCompare(maxs, ent->maxs)) {
+            continue;
+        }
+
+        lag_saved[lag_numsaved].ent = ent;
+        VectorCopy(ent->s.origin, lag_saved[lag_numsaved].origin);
+        VectorCopy(ent->mins, lag_saved[lag_numsaved].mins);
+        VectorCopy(ent->maxs, lag_saved[lag_numsaved].maxs);
+        VectorCopy(origin, lag_saved[lag_numsaved].rewound);
+
+        VectorCopy(origin, ent->s.origin);
+        VectorCopy(mins, ent->mins);
+        VectorCopy(maxs, ent->maxs);
+        gi.linkentity(ent);
+
+        lag_saved[lag_numsaved].linkcount = ent->linkcount;
+        lag_numsaved++;
+    }
+
+    level.perf.antilag_rewinds++;
+    level.perf.antilag_relinks += lag_numsaved;
+}
+
+/*
+=================
+G_RestorePlayers
+
+Moves players back to their real positions. Players relinked by game
+code in between (killed by the shot, for example) keep their new bounds
+and are only shifted by the rewind offset.
+=================
+*/
+void G_RestorePlayers(void)
+{
+    edict_t *ent;
+    vec3_t delta;
+    int i;
+
+    for (i = 0; i < lag_numsaved; i++) {
+        ent = lag_saved[i].ent;
+        if (ent->linkcount == lag_saved[i].linkcount) {
+            VectorCopy(lag_saved[i].origin, ent->s.origin);
+            VectorCopy(lag_saved[i].mins, ent->mins);
+            VectorCopy(lag_saved[i].maxs, ent->maxs);
+        } else {
+            VectorSubtract(lag_saved[i].origin, lag_saved[i].rewound, delta);
+            VectorAdd(ent->s.origin, delta, ent->s.origin);
+        }
+        gi.linkentity(ent);
+    }
+
+    lag_numsaved = 0;
+}
+
+
 /*
 =================
 fire_lead
 
 This is an internal support routine used for bullet/pellet based weapons.
+Work that only depends on the shooter and aim direction is done once in
+lead_setup, so that all pellets of a shotgun blast can share it.
 =================
 */
-static void fire_lead(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int te_impact, int hspread, int vspread, int mod)
-{
+typedef struct {
+    edict_t     *self;
+    vec_t       *start;
+    vec_t       *aimdir;
+    vec3_t      forward, right, up;
+    int         hspread, vspread;
+    bool        blocked;    // muzzle is behind something, all shots hit it
+    trace_t     blocktr;
+    bool        inwater;    // muzzle is in water
+    int         traces;
+} lead_t;
+
+// single shot result
+typedef struct {
     trace_t     tr;
+    bool        water;
+    vec3_t      water_start;
+} lead_shot_t;
+
+static void lead_setup(lead_t *l, edict_t *self, vec3_t start, vec3_t aimdir, int hspread, int vspread)
+{
+    vec3_t      dir;
+
+    l->self = self;
+    l->start = start;
+    l->aimdir = aimdir;
+    l->hspread = hspread;
+    l->vspread = vspread;
+    l->traces = 1;
+
+    l->blocktr = gi.trace(self->s.origin, NULL, NULL, start, self, MASK_SHOT);
+    l->blocked = l->blocktr.fraction < 1.0f;
+    if (l->blocked)
+        return;
+
+    vectoangles(aimdir, dir);
+    AngleVectors(dir, l->forward, l->right, l->up);
+
+    l->inwater = gi.pointcontents(start) & MASK_WATER;
+}
+
+static void lead_trace(lead_t *l, lead_shot_t *s)
+{
     vec3_t      dir;
     vec3_t      forward, right, up;
     vec3_t      end;
     float       r;
     float       u;
-    vec3_t      water_start;
-    bool        water = false;
     int         content_mask = MASK_SHOT | MASK_WATER;
 
-    tr = gi.trace(self->s.origin, NULL, NULL, start, self, MASK_SHOT);
-    if (!(tr.fraction < 1.0f)) {
-        vectoangles(aimdir, dir);
-        AngleVectors(dir, forward, right, up);
-
-        r = crandom() * hspread;
-        u = crandom() * vspread;
-        VectorMA(start, 8192, forward, end);
-        VectorMA(end, r, right, end);
-        VectorMA(end, u, up, end);
-
-        if (gi.pointcontents(start) & MASK_WATER) {
-            water = true;
-            VectorCopy(start, water_start);
-            content_mask &= ~MASK_WATER;
-        }
+    s->water = false;
 
-        tr = gi.trace(start, NULL, NULL, end, self, content_mask);
-
-        // see if we hit water
-        if (tr.contents & MASK_WATER) {
-            int     color;
-
-            water = true;
-            VectorCopy(tr.endpos, water_start);
-
-            if (!VectorCompare(start, tr.endpos)) {
-                if (tr.contents & CONTENTS_WATER) {
-                    if (strcmp(tr.surface->name, "*brwater") == 0)
-                        color = SPLASH_BROWN_WATER;
-                    else
-                        color = SPLASH_BLUE_WATER;
-                } else if (tr.contents & CONTENTS_SLIME)
-                    color = SPLASH_SLIME;
-                else if (tr.contents & CONTENTS_LAVA)
-                    color = SPLASH_LAVA;
+    if (l->blocked) {
+        s->tr = l->blocktr;
+        return;
+    }
+
+    r = crandom() * l->hspread;
+    u = crandom() * l->vspread;
+    VectorMA(l->start, 8192, l->forward, end);
+    VectorMA(end, r, l->right, end);
+    VectorMA(end, u, l->up, end);
+
+    if (l->inwater) {
+        s->water = true;
+        VectorCopy(l->start, s->water_start);
+        content_mask &= ~MASK_WATER;
+    }
+
+    s->tr = gi.trace(l->start, NULL, NULL, end, l->self, content_mask);
+    l->traces++;
+
+    // see if we hit water
+    if (s->tr.contents & MASK_WATER) {
+        trace_t *tr = &s->tr;
+        int     color;
+
+        s->water = true;
+        VectorCopy(tr->endpos, s->water_start);
+
+        if (!VectorCompare(l->start, tr->endpos)) {
+            if (tr->contents & CONTENTS_WATER) {
+                if (strcmp(tr->surface->name, "*brwater") == 0)
+                    color = SPLASH_BROWN_WATER;
                 else
-                    color = SPLASH_UNKNOWN;
-
-                if (color != SPLASH_UNKNOWN) {
-                    gi.WriteByte(svc_temp_entity);
-                    gi.WriteByte(TE_SPLASH);
-                    gi.WriteByte(8);
-                    gi.WritePosition(tr.endpos);
-                    gi.WriteDir(tr.plane.normal);
-                    gi.WriteByte(color);
-                    gi.multicast(tr.endpos, MULTICAST_PVS);
-                }
+                    color = SPLASH_BLUE_WATER;
+            } else if (tr->contents & CONTENTS_SLIME)
+                color = SPLASH_SLIME;
+            else if (tr->contents & CONTENTS_LAVA)
+                color = SPLASH_LAVA;
+            else
+                color = SPLASH_UNKNOWN;
 
-                // change bullet's course when it enters water
-                VectorSubtract(end, start, dir);
-                vectoangles(dir, dir);
-                AngleVectors(dir, forward, right, up);
-                r = crandom() * hspread * 2;
-                u = crandom() * vspread * 2;
-                VectorMA(water_start, 8192, forward, end);
-                VectorMA(end, r, right, end);
-                VectorMA(end, u, up, end);
+            if (color != SPLASH_UNKNOWN) {
+                gi.WriteByte(svc_temp_entity);
+                gi.WriteByte(TE_SPLASH);
+                gi.WriteByte(8);
+                gi.WritePosition(tr->endpos);
+                gi.WriteDir(tr->plane.normal);
+                gi.WriteByte(color);
+                gi.multicast(tr->endpos, MULTICAST_PVS);
             }
 
-            // re-trace ignoring water this time
-            tr = gi.trace(water_start, NULL, NULL, end, self, MASK_SHOT);
+            // change bullet's course when it enters water
+            VectorSubtract(end, l->start, dir);
+            vectoangles(dir, dir);
+            AngleVectors(dir, forward, right, up);
+            r = crandom() * l->hspread * 2;
+            u = crandom() * l->vspread * 2;
+            VectorMA(s->water_start, 8192, forward, end);
+            VectorMA(end, r, right, end);
+            VectorMA(end, u, up, end);
         }
+
+        // re-trace ignoring water this time
+        s->tr = gi.trace(s->water_start, NULL, NULL, end, l->self, MASK_SHOT);
+        l->traces++;
     }
+}
+
+// returns true if shot hit something that takes damage
+static bool lead_hits(lead_shot_t *s)
+{
+    trace_t *tr = &s->tr;
+
+    if (tr->surface && (tr->surface->flags & SURF_SKY))
+        return false;
+
+    return tr->fraction < 1.0f && tr->ent->takedamage;
+}
+
+static void lead_impact(lead_t *l, lead_shot_t *s, int damage, int kick, int te_impact, int mod)
+{
+    trace_t *tr = &s->tr;
 
     // send gun puff / flash
-    if (!((tr.surface) && (tr.surface->flags & SURF_SKY))) {
-        if (tr.fraction < 1.0f) {
-            if (tr.ent->takedamage) {
-                T_Damage(tr.ent, self, self, aimdir, tr.endpos, tr.plane.normal, damage, kick, DAMAGE_BULLET, mod);
+    if (!((tr->surface) && (tr->surface->flags & SURF_SKY))) {
+        if (tr->fraction < 1.0f) {
+            if (tr->ent->takedamage) {
+                T_Damage(tr->ent, l->self, l->self, l->aimdir, tr->endpos, tr->plane.normal, damage, kick, DAMAGE_BULLET, mod);
             } else {
-                if (strncmp(tr.surface->name, "sky", 3) != 0) {
-                    gi.WriteByte(svc_temp_entity);
-                    gi.WriteByte(te_impact);
-                    gi.WritePosition(tr.endpos);
-                    gi.WriteDir(tr.plane.normal);
-                    gi.multicast(tr.endpos, MULTICAST_PVS);
+                if (strncmp(tr->surface->name, "sky", 3) != 0) {
+                    G_ImpactEffect(te_impact, tr->endpos, tr->plane.normal);
                 }
             }
         }
     }
+}
 
-    // if went through water, determine where the end and make a bubble trail
-    if (water) {
-        vec3_t  pos;
-
-        VectorSubtract(tr.endpos, water_start, dir);
-        VectorNormalize(dir);
-        VectorMA(tr.endpos, -2, dir, pos);
-        if (gi.pointcontents(pos) & MASK_WATER)
-            VectorCopy(pos, tr.endpos);
-        else
-            tr = gi.trace(pos, NULL, NULL, water_start, tr.ent, MASK_WATER);
+// if went through water, determine where the end and make a bubble trail
+static void lead_bubbles(lead_t *l, lead_shot_t *s)
+{
+    trace_t     tr = s->tr;
+    vec3_t      dir;
+    vec3_t      pos;
 
-        VectorAdd(water_start, tr.endpos, pos);
-        VectorScale(pos, 0.5f, pos);
+    if (!s->water)
+        return;
 
-        gi.WriteByte(svc_temp_entity);
-        gi.WriteByte(TE_BUBBLETRAIL);
-        gi.WritePosition(water_start);
-        gi.WritePosition(tr.endpos);
-        gi.multicast(pos, MULTICAST_PVS);
+    VectorSubtract(tr.endpos, s->water_start, dir);
+    VectorNormalize(dir);
+    VectorMA(tr.endpos, -2, dir, pos);
+    if (gi.pointcontents(pos) & MASK_WATER) {
+        VectorCopy(pos, tr.endpos);
+    } else {
+        tr = gi.trace(pos, NULL, NULL, s->water_start, tr.ent, MASK_WATER);
+        l->traces++;
     }
+
+    VectorAdd(s->water_start, tr.endpos, pos);
+    VectorScale(pos, 0.5f, pos);
+
+    gi.WriteByte(svc_temp_entity);
+    gi.WriteByte(TE_BUBBLETRAIL);
+    gi.WritePosition(s->water_start);
+    gi.WritePosition(tr.endpos);
+    gi.multicast(pos, MULTICAST_PVS);
+}
+
+static void fire_lead(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int te_impact, int hspread, int vspread, int mod)
+{
+    lead_t      l;
+    lead_shot_t s;
+
+    lead_setup(&l, self, start, aimdir, hspread, vspread);
+    lead_trace(&l, &s);
+    lead_impact(&l, &s, damage, kick, te_impact, mod);
+    lead_bubbles(&l, &s);
 }
 
 
@@ -154,7 +436,9 @@ pistols, rifles, etc....
 */
 void fire_bullet(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int hspread, int vspread, int mod)
 {
+    G_RewindPlayers(self);
     fire_lead(self, start, aimdir, damage, kick, TE_GUNSHOT, hspread, vspread, mod);
+    G_RestorePlayers();
 }
 
 
@@ -163,14 +447,70 @@ void fire_bullet(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kic
 fire_shotgun
 
 Shoots shotgun pellets.  Used by shotgun and super shotgun.
+
+With g_merge_pellets enabled, pellets hitting the same entity are summed
+into a single T_Damage call at the point of the first hit.
 =================
 */
+#define MAX_PELLET_HITS 32
+
+typedef struct {
+    edict_t     *ent;
+    vec3_t      point;
+    vec3_t      normal;
+    int         count;
+} pellet_hit_t;
+
 void fire_shotgun(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int hspread, int vspread, int count, int mod)
 {
-    int     i;
+    pellet_hit_t    hits[MAX_PELLET_HITS], *hit;
+    int             i, j, numhits = 0;
+    bool            merge = g_merge_pellets->value;
+    lead_t          l;
+    lead_shot_t     s;
+
+    G_RewindPlayers(self);
+
+    lead_setup(&l, self, start, aimdir, hspread, vspread);
+
+    for (i = 0; i < count; i++) {
+        lead_trace(&l, &s);
+
+        if (merge && lead_hits(&s)) {
+            for (j = 0, hit = hits; j < numhits; j++, hit++)
+                if (hit->ent == s.tr.ent)
+                    break;
+            if (j < numhits) {
+                hit->count++;
+            } else if (numhits < MAX_PELLET_HITS) {
+                hit->ent = s.tr.ent;
+                VectorCopy(s.tr.endpos, hit->point);
+                VectorCopy(s.tr.plane.normal, hit->normal);
+                hit->count = 1;
+                numhits++;
+            } else {
+                lead_impact(&l, &s, damage, kick, TE_SHOTGUN, mod);
+            }
+        } else {
+            lead_impact(&l, &s, damage, kick, TE_SHOTGUN, mod);
+        }
+
+        lead_bubbles(&l, &s);
+    }
+
+    for (i = 0, hit = hits; i < numhits; i++, hit++) {
+        // previous damage may have removed it
+        if (!hit->ent->inuse || !hit->ent->takedamage)
+            continue;
+        T_Damage(hit->ent, self, self, aimdir, hit->point, hit->normal,
+                 damage * hit->count, kick * hit->count, DAMAGE_BULLET, mod);
+        level.perf.pellet_damages++;
+    }
 
-    for (i = 0; i < count; i++)
-        fire_lead(self, start, aimdir, damage, kick, TE_SHOTGUN, hspread, vspread, mod);
+    G_RestorePlayers();
+
+    level.perf.pellet_shots++;
+    level.perf.pellet_traces += l.traces;
 }
 
 
@@ -219,36 +559,17 @@ void fire_blaster(edict_t *self, vec3_t start, vec3_t dir, int damage, int speed
 {
     edict_t *bolt;
     trace_t tr;
+    vec3_t  velocity;
 
     VectorNormalize(dir);
+    VectorScale(dir, speed, velocity);
 
-    bolt = G_Spawn();
-    bolt->svflags = SVF_DEADMONSTER;
-    // yes, I know it looks weird that projectiles are deadmonsters
-    // what this means is that when prediction is used against the object
-    // (blaster/hyperblaster shots), the player won't be solid clipped against
-    // the object.  Right now trying to run into a firing hyperblaster
-    // is very jerky since you are predicted 'against' the shots.
-    VectorCopy(start, bolt->s.origin);
-    VectorCopy(start, bolt->old_origin);
+    bolt = G_SpawnProjectile(PROJ_BLASTER, self, start, velocity);
     vectoangles(dir, bolt->s.angles);
-    VectorScale(dir, speed, bolt->velocity);
-    bolt->movetype = MOVETYPE_FLYMISSILE;
-    bolt->clipmask = MASK_SHOT;
-    bolt->solid = SOLID_BBOX;
-    bolt->flags = FL_NOCLIP_PROJECTILE;
     bolt->s.effects |= effect;
-    bolt->s.renderfx |= RF_NOSHADOW;
-    VectorClear(bolt->mins);
-    VectorClear(bolt->maxs);
-    bolt->s.modelindex = gi.modelindex("models/objects/laser/tris.md2");
-    bolt->s.sound = gi.soundindex("misc/lasfly.wav");
-    bolt->owner = self;
-    bolt->touch = blaster_touch;
     bolt->nextthink = level.framenum + 2 * HZ;
     bolt->think = G_FreeEdict;
     bolt->dmg = damage;
-    bolt->classname = "bolt";
     if (hyper)
         bolt->spawnflags = 1;
     gi.linkentity(bolt);
@@ -351,34 +672,24 @@ void fire_grenade(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int sp
     edict_t *grenade;
     vec3_t  dir;
     vec3_t  forward, right, up;
+    vec3_t  velocity;
     float   scale;
 
     vectoangles(aimdir, dir);
     AngleVectors(dir, forward, right, up);
 
-    grenade = G_Spawn();
-    VectorCopy(start, grenade->s.origin);
-    VectorCopy(start, grenade->old_origin);
-    VectorScale(aimdir, speed, grenade->velocity);
+    VectorScale(aimdir, speed, velocity);
     scale = 200 + crandom() * 10.0f;
-    VectorMA(grenade->velocity, scale, up, grenade->velocity);
+    VectorMA(velocity, scale, up, velocity);
     scale = crandom() * 10.0f;
-    VectorMA(grenade->velocity, scale, right, grenade->velocity);
+    VectorMA(velocity, scale, right, velocity);
+
+    grenade = G_SpawnProjectile(PROJ_GRENADE, self, start, velocity);
     VectorSet(grenade->avelocity, 300, 300, 300);
-    grenade->movetype = MOVETYPE_BOUNCE;
-    grenade->clipmask = MASK_SHOT;
-    grenade->solid = SOLID_BBOX;
-    grenade->s.effects |= EF_GRENADE;
-    VectorClear(grenade->mins);
-    VectorClear(grenade->maxs);
-    grenade->s.modelindex = gi.modelindex("models/objects/grenade/tris.md2");
-    grenade->owner = self;
-    grenade->touch = Grenade_Touch;
     grenade->nextthink = level.framenum + timer;
     grenade->think = Grenade_Explode;
     grenade->dmg = damage;
     grenade->dmg_radius = damage_radius;
-    grenade->classname = "grenade";
 
     gi.linkentity(grenade);
 }
@@ -388,39 +699,28 @@ void fire_grenade2(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int s
     edict_t *grenade;
     vec3_t  dir;
     vec3_t  forward, right, up;
+    vec3_t  velocity;
     float   scale;
 
     vectoangles(aimdir, dir);
     AngleVectors(dir, forward, right, up);
 
-    grenade = G_Spawn();
-    VectorCopy(start, grenade->s.origin);
-    VectorCopy(start, grenade->old_origin);
-    VectorScale(aimdir, speed, grenade->velocity);
+    VectorScale(aimdir, speed, velocity);
     scale = 200 + crandom() * 10.0f;
-    VectorMA(grenade->velocity, scale, up, grenade->velocity);
+    VectorMA(velocity, scale, up, velocity);
     scale = crandom() * 10.0f;
-    VectorMA(grenade->velocity, scale, right, grenade->velocity);
+    VectorMA(velocity, scale, right, velocity);
+
+    grenade = G_SpawnProjectile(PROJ_HGRENADE, self, start, velocity);
     VectorSet(grenade->avelocity, 300, 300, 300);
-    grenade->movetype = MOVETYPE_BOUNCE;
-    grenade->clipmask = MASK_SHOT;
-    grenade->solid = SOLID_BBOX;
-    grenade->s.effects |= EF_GRENADE;
-    VectorClear(grenade->mins);
-    VectorClear(grenade->maxs);
-    grenade->s.modelindex = gi.modelindex("models/objects/grenade2/tris.md2");
-    grenade->owner = self;
-    grenade->touch = Grenade_Touch;
     grenade->nextthink = level.framenum + timer;
     grenade->think = Grenade_Explode;
     grenade->dmg = damage;
     grenade->dmg_radius = damage_radius;
-    grenade->classname = "hgrenade";
     if (held)
         grenade->spawnflags = 3;
     else
         grenade->spawnflags = 1;
-    grenade->s.sound = gi.soundindex("weapons/hgrenc1b.wav");
 
     if (timer <= 0)
         Grenade_Explode(grenade);
@@ -477,29 +777,18 @@ void rocket_touch(edict_t *ent, edict_t *other, cplane_t *plane, csurface_t *sur
 void fire_rocket(edict_t *self, vec3_t start, vec3_t dir, int damage, int speed, float damage_radius, int radius_damage)
 {
     edict_t *rocket;
+    vec3_t  velocity;
 
-    rocket = G_Spawn();
-    VectorCopy(start, rocket->s.origin);
-    VectorCopy(start, rocket->old_origin);
+    VectorScale(dir, speed, velocity);
+
+    rocket = G_SpawnProjectile(PROJ_ROCKET, self, start, velocity);
     VectorCopy(dir, rocket->movedir);
     vectoangles(dir, rocket->s.angles);
-    VectorScale(dir, speed, rocket->velocity);
-    rocket->movetype = MOVETYPE_FLYMISSILE;
-    rocket->clipmask = MASK_SHOT;
-    rocket->solid = SOLID_BBOX;
-    rocket->s.effects |= EF_ROCKET;
-    VectorClear(rocket->mins);
-    VectorClear(rocket->maxs);
-    rocket->s.modelindex = gi.modelindex("models/objects/rocket/tris.md2");
-    rocket->owner = self;
-    rocket->touch = rocket_touch;
     rocket->nextthink = level.framenum + 8000 * HZ / speed;
     rocket->think = G_FreeEdict;
     rocket->dmg = damage;
     rocket->radius_dmg = radius_damage;
     rocket->dmg_radius = damage_radius;
-    rocket->s.sound = gi.soundindex("weapons/rockfly.wav");
-    rocket->classname = "rocket";
 
     gi.linkentity(rocket);
 }
@@ -508,49 +797,159 @@ void fire_rocket(edict_t *self, vec3_t start, vec3_t dir, int damage, int speed,
 /*
 =================
 fire_rail
+
+The rail goes through all bounding box entities in its path. Instead of
+tracing again after each of them, the world is traced once and the boxes
+of entities linked along the segment are clipped against it, in order.
 =================
 */
+typedef struct {
+    edict_t     *ent;
+    float       frac;
+    vec3_t      normal;
+} rail_hit_t;
+
+static int RailHitCmp(const void *p1, const void *p2)
+{
+    const rail_hit_t *a = p1;
+    const rail_hit_t *b = p2;
+
+    if (a->frac != b->frac)
+        return a->frac < b->frac ? -1 : 1;
+    return (a->ent > b->ent) - (a->ent < b->ent);
+}
+
+// returns true if segment from start along dir enters box of ent,
+// boxes containing start are left without a hit like with gi.trace
+static bool RailClipBox(edict_t *ent, const vec3_t start, const vec3_t dir, rail_hit_t *hit)
+{
+    float   enter = -1, leave = 1, t1, t2, t;
+    int     i, axis = -1;
+    vec3_t  mins, maxs;
+
+    VectorAdd(ent->s.origin, ent->mins, mins);
+    VectorAdd(ent->s.origin, ent->maxs, maxs);
+
+    for (i = 0; i < 3; i++) {
+        if (dir[i] == 0) {
+            if (start[i] < mins[i] || start[i] > maxs[i])
+                return false;
+            continue;
+        }
+        t1 = (mins[i] - start[i]) / dir[i];
+        t2 = (maxs[i] - start[i]) / dir[i];
+        if (t1 > t2) {
+            t = t1;
+            t1 = t2;
+            t2 = t;
+        }
+        if (t1 > enter) {
+            enter = t1;
+            axis = i;
+        }
+        if (t2 < leave)
+            leave = t2;
+    }
+
+    if (enter < 0 || enter >= leave || enter > 1)
+        return false;
+
+    hit->ent = ent;
+    hit->frac = enter;
+    VectorClear(hit->normal);
+    hit->normal[axis] = dir[axis] < 0 ? 1 : -1;
+    return true;
+}
+
 void fire_rail(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick)
 {
-    vec3_t      from;
-    vec3_t      end;
+    static edict_t  *touch[MAX_EDICTS];
+    static rail_hit_t hits[MAX_EDICTS];
+    vec3_t      end, dir, point, mins, maxs;
     trace_t     tr;
-    edict_t     *ignore;
-    int         mask;
-    bool        water;
-    float       lastfrac;
+    edict_t     *ignore, *ent;
+    int         mask, i, num, numhits;
+    bool        water, stuck;
+    float       from;
 
     VectorMA(start, 8192, aimdir, end);
-    VectorCopy(start, from);
-    ignore = self;
     water = false;
-    mask = MASK_SHOT | CONTENTS_SLIME | CONTENTS_LAVA;
-    lastfrac = 1;
-    while (ignore) {
-        tr = gi.trace(from, NULL, NULL, end, ignore, mask);
-
-        if (tr.contents & (CONTENTS_SLIME | CONTENTS_LAVA)) {
-            mask &= ~(CONTENTS_SLIME | CONTENTS_LAVA);
-            water = true;
+    mask = (MASK_SHOT & ~(CONTENTS_MONSTER | CONTENTS_DEADMONSTER)) | CONTENTS_SLIME | CONTENTS_LAVA;
+
+    G_RewindPlayers(self);
+
+    // find where the world stops the rail
+    tr = gi.trace(start, NULL, NULL, end, self, mask);
+    if (tr.contents & (CONTENTS_SLIME | CONTENTS_LAVA)) {
+        mask &= ~(CONTENTS_SLIME | CONTENTS_LAVA);
+        water = true;
+        tr = gi.trace(tr.endpos, NULL, NULL, end, self, mask);
+        level.perf.rail_traces++;
+    }
+    level.perf.rail_traces++;
+    level.perf.rail_shots++;
+
+    // gather boxes along the segment, nearest first
+    VectorSubtract(tr.endpos, start, dir);
+    for (i = 0; i < 3; i++) {
+        mins[i] = min(start[i], tr.endpos[i]);
+        maxs[i] = max(start[i], tr.endpos[i]);
+    }
+
+    num = gi.BoxEdicts(mins, maxs, touch, MAX_EDICTS, AREA_SOLID);
+    numhits = 0;
+    for (i = 0; i < num; i++) {
+        if (touch[i]->solid != SOLID_BBOX)
+            continue;
+        if (RailClipBox(touch[i], start, dir, &hits[numhits]))
+            numhits++;
+    }
+    qsort(hits, numhits, sizeof(hits[0]), RailHitCmp);
+    level.perf.rail_boxes += numhits;
+
+    // same rules as tracing again from each hit, ignoring last entity.
+    // boxes containing the point the rail restarts from were entered
+    // before it, so they have already been judged in order
+    ignore = self;
+    from = 0;
+    stuck = false;
+    for (i = 0; i < numhits && ignore; i++) {
+        ent = hits[i].ent;
+        if (ent == ignore || ent->owner == ignore || ignore->owner == ent)
+            continue;
+        if (!ent->inuse || ent->solid != SOLID_BBOX)
+            continue;   // removed by previous damage
+
+        // stop if two entities in a row are hit without moving
+        if (hits[i].frac > from) {
+            from = hits[i].frac;
+            stuck = false;
+            ignore = ent;
+        } else if (stuck) {
+            ignore = NULL;
+            VectorMA(start, hits[i].frac, dir, tr.endpos);
         } else {
-            //ZOID--added so rail goes through SOLID_BBOX entities (gibs, etc)
-            if (((tr.ent->svflags & SVF_MONSTER) || (tr.ent->client) ||
-                (tr.ent->solid == SOLID_BBOX)) && (lastfrac + tr.fraction > 0))
-                ignore = tr.ent;
-            else
-                ignore = NULL;
+            stuck = true;
+            ignore = ent;
+        }
 
-            if ((tr.ent != self) && (tr.ent->takedamage)) {
-                G_BeginDamage();
-                T_Damage(tr.ent, self, self, aimdir, tr.endpos, tr.plane.normal, damage, kick, 0, MOD_RAILGUN);
-                G_EndDamage();
-            }
+        if ((ent != self) && (ent->takedamage)) {
+            VectorMA(start, hits[i].frac, dir, point);
+            G_BeginDamage();
+            T_Damage(ent, self, self, aimdir, point, hits[i].normal, damage, kick, 0, MOD_RAILGUN);
+            G_EndDamage();
         }
+    }
 
-        VectorCopy(tr.endpos, from);
-        lastfrac = tr.fraction;
+    // stopped by the world or a brush entity
+    if (ignore && tr.fraction < 1.0f && tr.ent != self && tr.ent->takedamage) {
+        G_BeginDamage();
+        T_Damage(tr.ent, self, self, aimdir, tr.endpos, tr.plane.normal, damage, kick, 0, MOD_RAILGUN);
+        G_EndDamage();
     }
 
+    G_RestorePlayers();
+
     // send gun puff / flash
     gi.WriteByte(svc_temp_entity);
     gi.WriteByte(TE_RAILTRAIL);
@@ -649,43 +1048,78 @@ void bfg_touch(edict_t *self, edict_t *other, cplane_t *plane, csurface_t *surf)
 }
 
 
+static int EdictNumCmp(const void *p1, const void *p2)
+{
+    edict_t *a = *(edict_t **)p1;
+    edict_t *b = *(edict_t **)p2;
+
+    return (a > b) - (a < b);
+}
+
+#define BFG_LASER_RADIUS    256
+
+/*
+=================
+bfg_think
+
+Only players and monsters are lasered. Candidates come from the solid
+area list around the ball instead of scanning all edicts, sorted by
+entity number to keep the order findradius would give.
+=================
+*/
 void bfg_think(edict_t *self)
 {
+    static edict_t *touch[MAX_EDICTS];
     edict_t *ent;
     edict_t *ignore;
     vec3_t  point;
     vec3_t  dir;
     vec3_t  start;
     vec3_t  end;
+    vec3_t  mins, maxs;
     int     dmg;
     trace_t tr;
+    int     i, j, num;
 
     dmg = 5;
 
-    ent = NULL;
-    while ((ent = findradius(ent, self->s.origin, 256)) != NULL) {
+    for (j = 0; j < 3; j++) {
+        mins[j] = self->s.origin[j] - BFG_LASER_RADIUS;
+        maxs[j] = self->s.origin[j] + BFG_LASER_RADIUS;
+    }
+
+    num = gi.BoxEdicts(mins, maxs, touch, MAX_EDICTS, AREA_SOLID);
+    qsort(touch, num, sizeof(touch[0]), EdictNumCmp);
+
+    level.perf.bfg_thinks++;
+    level.perf.bfg_candidates += num;
+
+    for (i = 0; i < num; i++) {
+        ent = touch[i];
         if (ent == self)
             continue;
 
         if (ent == self->owner)
             continue;
 
-        if (!ent->takedamage)
+        if (!ent->inuse || !ent->takedamage)
             continue;
 
-        if (!(ent->svflags & SVF_MONSTER) && (!ent->client) && (strcmp(ent->classname, "misc_explobox") != 0))
+        if (!(ent->svflags & SVF_MONSTER) && (!ent->client))
             continue;
 
         VectorMA(ent->absmin, 0.5f, ent->size, point);
 
         VectorSubtract(point, self->s.origin, dir);
-        VectorNormalize(dir);
+        if (VectorNormalize(dir) > BFG_LASER_RADIUS)
+            continue;
 
         ignore = self;
         VectorCopy(self->s.origin, start);
         VectorMA(start, 2048, dir, end);
         while (1) {
             tr = gi.trace(start, NULL, NULL, end, ignore, CONTENTS_SOLID | CONTENTS_MONSTER | CONTENTS_DEADMONSTER);
+            level.perf.bfg_traces++;
 
             if (!tr.ent)
                 break;
@@ -723,30 +1157,143 @@ void bfg_think(edict_t *self)
 void fire_bfg(edict_t *self, vec3_t start, vec3_t dir, int damage, int speed, float damage_radius)
 {
     edict_t *bfg;
+    vec3_t  velocity;
 
-    bfg = G_Spawn();
-    VectorCopy(start, bfg->s.origin);
-    VectorCopy(start, bfg->old_origin);
+    VectorScale(dir, speed, velocity);
+
+    bfg = G_SpawnProjectile(PROJ_BFG, self, start, velocity);
     VectorCopy(dir, bfg->movedir);
     vectoangles(dir, bfg->s.angles);
-    VectorScale(dir, speed, bfg->velocity);
-    bfg->movetype = MOVETYPE_FLYMISSILE;
-    bfg->clipmask = MASK_SHOT;
-    bfg->solid = SOLID_BBOX;
-    bfg->s.effects |= EF_BFG | EF_ANIM_ALLFAST;
-    VectorClear(bfg->mins);
-    VectorClear(bfg->maxs);
-    bfg->s.modelindex = gi.modelindex("sprites/s_bfg1.sp2");
-    bfg->owner = self;
-    bfg->touch = bfg_touch;
     NEXT_KEYFRAME(bfg, bfg_think);
     bfg->radius_dmg = damage;
     bfg->dmg_radius = damage_radius;
-    bfg->classname = "bfg blast";
-    bfg->s.sound = gi.soundindex("weapons/bfg__l1a.wav");
 
     bfg->teammaster = bfg;
     bfg->teamchain = NULL;
 
     gi.linkentity(bfg);
 }
+
+
+/*
+==============================================================================
+
+PROJECTILE TEMPLATES
+
+==============================================================================
+*/
+
+typedef struct {
+    char        *classname;
+    const char  *model;
+    const char  *sound;
+    movetype_t  movetype;
+    int         effects;
+    int         renderfx;
+    int         svflags;
+    int         flags;
+    void        (*touch)(edict_t *self, edict_t *other, cplane_t *plane, csurface_t *surf);
+} projectile_template_t;
+
+static const projectile_template_t projectile_templates[PROJ_MAX] = {
+    // PROJ_BLASTER
+    // yes, I know it looks weird that projectiles are deadmonsters
+    // what this means is that when prediction is used against the object
+    // (blaster/hyperblaster shots), the player won't be solid clipped against
+    // the object.  Right now trying to run into a firing hyperblaster
+    // is very jerky since you are predicted 'against' the shots.
+    {
+        .classname  = "bolt",
+        .model      = "models/objects/laser/tris.md2",
+        .sound      = "misc/lasfly.wav",
+        .movetype   = MOVETYPE_FLYMISSILE,
+        .renderfx   = RF_NOSHADOW,
+        .svflags    = SVF_DEADMONSTER,
+        .flags      = FL_NOCLIP_PROJECTILE,
+        .touch      = blaster_touch
+    },
+
+    // PROJ_GRENADE
+    {
+        .classname  = "grenade",
+        .model      = "models/objects/grenade/tris.md2",
+        .movetype   = MOVETYPE_BOUNCE,
+        .effects    = EF_GRENADE,
+        .touch      = Grenade_Touch
+    },
+
+    // PROJ_HGRENADE
+    {
+        .classname  = "hgrenade",
+        .model      = "models/objects/grenade2/tris.md2",
+        .sound      = "weapons/hgrenc1b.wav",
+        .movetype   = MOVETYPE_BOUNCE,
+        .effects    = EF_GRENADE,
+        .touch      = Grenade_Touch
+    },
+
+    // PROJ_ROCKET
+    {
+        .classname  = "rocket",
+        .model      = "models/objects/rocket/tris.md2",
+        .sound      = "weapons/rockfly.wav",
+        .movetype   = MOVETYPE_FLYMISSILE,
+        .effects    = EF_ROCKET,
+        .touch      = rocket_touch
+    },
+
+    // PROJ_BFG
+    {
+        .classname  = "bfg blast",
+        .model      = "sprites/s_bfg1.sp2",
+        .sound      = "weapons/bfg__l1a.wav",
+        .movetype   = MOVETYPE_FLYMISSILE,
+        .effects    = EF_BFG | EF_ANIM_ALLFAST,
+        .touch      = bfg_touch
+    },
+};
+
+/*
+=================
+G_SpawnProjectile
+
+Spawns a point sized projectile owned by self and fills in the fields
+common to its type. Model and sound indices are looked up once per map
+instead of on every shot.
+=================
+*/
+edict_t *G_SpawnProjectile(projectile_t type, edict_t *self, vec3_t start, vec3_t velocity)
+{
+    const projectile_template_t *proj = &projectile_templates[type];
+    edict_t *ent;
+
+    if (!level.projectile_models[type]) {
+        level.projectile_models[type] = gi.modelindex(proj->model);
+        if (proj->sound)
+            level.projectile_sounds[type] = gi.soundindex(proj->sound);
+    }
+
+    ent = G_Spawn();
+    VectorCopy(start, ent->s.origin);
+    VectorCopy(start, ent->old_origin);
+    VectorCopy(velocity, ent->velocity);
+    VectorClear(ent->mins);
+    VectorClear(ent->maxs);
+    ent->movetype = proj->movetype;
+    ent->clipmask = MASK_SHOT;
+    ent->solid = SOLID_BBOX;
+    ent->svflags = proj->svflags;
+    ent->flags = proj->flags;
+    if (ent->flags & FL_NOCLIP_PROJECTILE)
+        level.noclip_projectiles++;
+    ent->s.effects = proj->effects;
+    ent->s.renderfx = proj->renderfx;
+    ent->s.modelindex = level.projectile_models[type];
+    ent->s.sound = level.projectile_sounds[type];
+    ent->owner = self;
+    ent->touch = proj->touch;
+    ent->classname = proj->classname;
+
+    level.perf.projectile_spawns++;
+    return ent;
+}
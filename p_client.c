@@ -67,6 +67,20 @@ void player_pain(edict_t *self, edict_t *other, float kick, int damage)
 }
 
 
+// returns true if rank strings need to be rebuilt
+static bool RankChanged(gclient_t *c, int rank, int total, int delta)
+{
+    if (c->level.rank == rank && c->level.ranktotal == total && c->level.rankdelta == delta) {
+        return false;
+    }
+
+    c->level.rank = rank;
+    c->level.ranktotal = total;
+    c->level.rankdelta = delta;
+    level.perf.rank_strings++;
+    return true;
+}
+
 int G_UpdateRanks(void)
 {
     gclient_t   *ranks[MAX_CLIENTS];
@@ -74,6 +88,8 @@ int G_UpdateRanks(void)
     char buffer[MAX_QPATH];
     int i, j, total, topscore;
 
+    G_DirtyScoreboard();
+
     total = G_CalcRanks(ranks);
     if (!total) {
         return 0;
@@ -83,16 +99,21 @@ int G_UpdateRanks(void)
     c = ranks[0];
     topscore = c->resp.score;
     j = total > 1 ? ranks[1]->resp.score : 0;
-    Q_snprintf(buffer, sizeof(buffer), "  +%2d", topscore - j);
-    G_PrivateString(c->edict, PCS_DELTA, buffer);
-    Q_snprintf(buffer, sizeof(buffer), "1/%d", total);
-    G_PrivateString(c->edict, PCS_RANK, va("%5s", buffer));
+    if (RankChanged(c, 1, total, topscore - j)) {
+        Q_snprintf(buffer, sizeof(buffer), "  +%2d", topscore - j);
+        G_PrivateString(c->edict, PCS_DELTA, buffer);
+        Q_snprintf(buffer, sizeof(buffer), "1/%d", total);
+        G_PrivateString(c->edict, PCS_RANK, va("%5s", buffer));
+    }
 
     UpdateChaseTargets(CHASE_LEADER, c->edict);
 
     // other players
     for (i = 1; i < total; i++) {
         c = ranks[i];
+        if (!RankChanged(c, i + 1, total, topscore - c->resp.score)) {
+            continue;
+        }
         Q_snprintf(buffer, sizeof(buffer), "  -%2d",
                    topscore - c->resp.score);
         for (j = 0; buffer[j]; j++) {
@@ -447,20 +468,49 @@ static void ClientObituary(edict_t *self, edict_t *inflictor, edict_t *attacker)
     G_UpdateRanks();
 }
 
-static int damaging;
+/*
+==============================================================================
+
+Damage accounting
+
+Weapon damage between players is recorded as events and turned into
+statistics once per frame. Damage done between G_BeginDamage and
+G_EndDamage belongs to a single shot, which counts as one hit no matter
+how many pellets or players it damaged (but railgun counts each player).
+
+==============================================================================
+*/
+
+#define MAX_DAMAGE_EVENTS   256
+
+typedef struct {
+    edict_t *targ;
+    edict_t *attacker;
+    frag_t  frag;
+    int     shot;
+    int     points;
+    bool    summed;
+} damage_event_t;
+
+static damage_event_t   damage_events[MAX_DAMAGE_EVENTS];
+static int              num_damage_events;
+static int              damage_shot;    // current shot, 0 if none
+static int              damage_shots;   // shots started so far
+static int              damage_hit_shot;    // last shot counted as hit
 
 void G_BeginDamage(void)
 {
-    damaging = 1;
+    damage_shot = ++damage_shots;
 }
 
 // called from T_Damage only when target is a living player
 // and inflictor is a real entity (not world)
 void G_AccountDamage(edict_t *targ, edict_t *inflictor, edict_t *attacker, int points)
 {
+    damage_event_t *ev;
     frag_t frag;
 
-    if (!damaging) {
+    if (!damage_shot) {
         return;
     }
 
@@ -469,24 +519,68 @@ void G_AccountDamage(edict_t *targ, edict_t *inflictor, edict_t *attacker, int p
         return; // only care about weapons
     }
 
-    targ->client->resp.damage_recvd += points;
-    if (targ == attacker) {
-        return; // no credit for shooting yourself
-    }
-
-    attacker->client->resp.damage_given += points;
-
-    // don't count multiple damage as multiple hits (but railgun still counts)
-    if (damaging == 1 || frag == FRAG_RAILGUN) {
-        attacker->client->resp.frags[frag].hits++;
+    if (num_damage_events == MAX_DAMAGE_EVENTS) {
+        G_FlushDamage();
     }
 
-    damaging++;
+    ev = &damage_events[num_damage_events++];
+    ev->targ = targ;
+    ev->attacker = attacker;
+    ev->frag = frag;
+    ev->shot = damage_shot;
+    ev->points = points;
+    ev->summed = false;
+    level.perf.damage_events++;
 }
 
 void G_EndDamage(void)
 {
-    damaging = 0;
+    damage_shot = 0;
+}
+
+/*
+=================
+G_FlushDamage
+
+Sums recorded damage per attacker, target and weapon and credits it.
+Must be called before statistics are read or clients go away.
+=================
+*/
+void G_FlushDamage(void)
+{
+    damage_event_t *ev, *other;
+    int i, j, points;
+
+    for (i = 0, ev = damage_events; i < num_damage_events; i++, ev++) {
+        // don't count multiple damage as multiple hits (but railgun still counts)
+        if (ev->targ != ev->attacker &&
+            (ev->shot != damage_hit_shot || ev->frag == FRAG_RAILGUN)) {
+            ev->attacker->client->resp.frags[ev->frag].hits++;
+            damage_hit_shot = ev->shot;
+        }
+
+        if (ev->summed) {
+            continue;
+        }
+
+        points = ev->points;
+        for (j = i + 1, other = ev + 1; j < num_damage_events; j++, other++) {
+            if (!other->summed && other->targ == ev->targ &&
+                other->attacker == ev->attacker && other->frag == ev->frag) {
+                points += other->points;
+                other->summed = true;
+            }
+        }
+
+        ev->targ->client->resp.damage_recvd += points;
+        if (ev->targ != ev->attacker) {
+            // no credit for shooting yourself
+            ev->attacker->client->resp.damage_given += points;
+        }
+        level.perf.damage_sums++;
+    }
+
+    num_damage_events = 0;
 }
 
 
@@ -581,6 +675,7 @@ void player_die(edict_t *self, edict_t *inflictor, edict_t *attacker, int damage
 
     self->takedamage = DAMAGE_YES;
     self->movetype = MOVETYPE_TOSS;
+    G_WakeEntity(self);
 
     self->s.modelindex2 = 0;    // remove linked weapon model
 
@@ -686,61 +781,103 @@ static edict_t *SelectRandomDeathmatchSpawnPoint(void)
 
 /*
 ================
-PlayersRangeFromSpot
+SpawnRanges
 
-Returns the distance to the nearest player from the given spot
+Returns the distance to the nearest living player from each spawn point.
+Distances from each player are cached and only recomputed once the player
+moves, dies or spawns. A spawn point's range is searched again across
+all players only when the player it was measured from moves away or
+dies; otherwise it is lowered in place by closer players.
 ================
 */
-static float PlayersRangeFromSpot(edict_t *spot)
+static const float *SpawnRanges(void)
 {
+    bool    rescan[MAX_SPAWNS];
     edict_t *player;
-    float   bestplayerdistance;
     vec3_t  v;
-    int     n;
-    float   playerdistance;
+    int     i, n;
+    bool    alive, rebuild;
+    float   dist;
 
-    bestplayerdistance = 9999999;
+    // recompute everything if spawn points have changed
+    rebuild = !level.spawn_cache.valid;
 
-    for (n = 1; n <= game.maxclients; n++) {
-        player = &g_edicts[n];
+    for (i = 0; i < level.numspawns; i++)
+        rescan[i] = rebuild;
 
-        if (!player->inuse)
-            continue;
-        if (!PlayerSpawned(player))
-            continue;
+    for (n = 0; n < game.maxclients; n++) {
+        player = &g_edicts[n + 1];
+
+        alive = player->inuse && PlayerSpawned(player) && player->health > 0;
+        if (!rebuild && alive == level.spawn_cache.alive[n]) {
+            if (!alive)
+                continue;
+            if (VectorCompare(player->s.origin, level.spawn_cache.origins[n]))
+                continue;
+        }
 
-        if (player->health <= 0)
+        level.spawn_cache.alive[n] = alive;
+
+        if (!alive) {
+            for (i = 0; i < level.numspawns; i++) {
+                if (level.spawn_cache.nearest[i] == n)
+                    rescan[i] = true;
+            }
             continue;
+        }
 
-        VectorSubtract(spot->s.origin, player->s.origin, v);
-        playerdistance = VectorLength(v);
+        VectorCopy(player->s.origin, level.spawn_cache.origins[n]);
+        for (i = 0; i < level.numspawns; i++) {
+            VectorSubtract(level.spawns[i]->s.origin, player->s.origin, v);
+            dist = VectorLength(v);
+            level.spawn_cache.dists[n][i] = dist;
+            if (rescan[i])
+                continue;
+            if (dist < level.spawn_cache.ranges[i]) {
+                level.spawn_cache.ranges[i] = dist;
+                level.spawn_cache.nearest[i] = n;
+            } else if (level.spawn_cache.nearest[i] == n) {
+                rescan[i] = true;
+            }
+        }
+        level.perf.spawn_dists += level.numspawns;
+    }
 
-        if (playerdistance < bestplayerdistance)
-            bestplayerdistance = playerdistance;
+    for (i = 0; i < level.numspawns; i++) {
+        if (!rescan[i])
+            continue;
+        level.spawn_cache.ranges[i] = 9999999;
+        level.spawn_cache.nearest[i] = -1;
+        for (n = 0; n < game.maxclients; n++) {
+            if (!level.spawn_cache.alive[n])
+                continue;
+            if (level.spawn_cache.dists[n][i] < level.spawn_cache.ranges[i]) {
+                level.spawn_cache.ranges[i] = level.spawn_cache.dists[n][i];
+                level.spawn_cache.nearest[i] = n;
+            }
+        }
+        level.perf.spawn_rescans++;
     }
+    level.spawn_cache.valid = true;
 
-    return bestplayerdistance;
+    return level.spawn_cache.ranges;
 }
 
 static edict_t *SelectRandomDeathmatchSpawnPointAvoidingTelefrag(void)
 {
-    edict_t *spawns[MAX_SPAWNS];
-    edict_t *spot;
-    float range;
+    const float *ranges = SpawnRanges();
+    const float *order[MAX_SPAWNS];
     int i;
 
     for (i = 0; i < level.numspawns; i++) {
-        spawns[i] = level.spawns[i];
+        order[i] = &ranges[i];
     }
 
-    G_ShuffleArray(spawns, level.numspawns);
+    G_ShuffleArray(order, level.numspawns);
 
     for (i = 0; i < level.numspawns; i++) {
-        spot = spawns[i];
-
-        range = PlayersRangeFromSpot(spot);
-        if (range > 64) {
-            return spot;
+        if (*order[i] > 64) {
+            return level.spawns[order[i] - ranges];
         }
     }
 
@@ -750,20 +887,18 @@ static edict_t *SelectRandomDeathmatchSpawnPointAvoidingTelefrag(void)
 
 static edict_t *SelectRandomDeathmatchSpawnPointAvoidingTwoClosest(void)
 {
+    const float *ranges = SpawnRanges();
     edict_t *spot, *spot1, *spot2;
-    float   range, range1, range2;
+    float   range1, range2;
     int     i;
 
     range1 = range2 = 99999;
     spot1 = spot2 = NULL;
 
     for (i = 0; i < level.numspawns; i++) {
-        spot = level.spawns[i];
-
-        range = PlayersRangeFromSpot(spot);
-        if (range < range1) {
-            range1 = range;
-            spot1 = spot;
+        if (ranges[i] < range1) {
+            range1 = ranges[i];
+            spot1 = level.spawns[i];
         }
     }
 
@@ -774,9 +909,8 @@ static edict_t *SelectRandomDeathmatchSpawnPointAvoidingTwoClosest(void)
             continue; // already recorded this one
         }
 
-        range = PlayersRangeFromSpot(spot);
-        if (range < range2) {
-            range2 = range;
+        if (ranges[i] < range2) {
+            range2 = ranges[i];
             spot2 = spot;
         }
     }
@@ -801,23 +935,21 @@ range order, spot2 will never be set
 */
 static edict_t *SelectRandomDeathmatchSpawnPointAvoidingTwoClosestBugged(void)
 {
+    const float *ranges = SpawnRanges();
     edict_t *spot, *spot1, *spot2;
-    float   range, range1, range2;
+    float   range1, range2;
     int     i;
 
     range1 = range2 = 99999;
     spot1 = spot2 = NULL;
 
     for (i = 0; i < level.numspawns; i++) {
-        spot = level.spawns[i];
-
-        range = PlayersRangeFromSpot(spot);
-        if (range < range1) {
-            range1 = range;
-            spot1 = spot;
-        } else if (range < range2) {
-            range2 = range;
-            spot2 = spot;
+        if (ranges[i] < range1) {
+            range1 = ranges[i];
+            spot1 = level.spawns[i];
+        } else if (ranges[i] < range2) {
+            range2 = ranges[i];
+            spot2 = level.spawns[i];
         }
     }
 
@@ -836,19 +968,17 @@ SelectFarthestDeathmatchSpawnPoint
 */
 static edict_t *SelectFarthestDeathmatchSpawnPoint(void)
 {
+    const float *ranges = SpawnRanges();
     edict_t *bestspot;
-    float   bestdistance, bestplayerdistance;
-    edict_t *spot;
+    float   bestdistance;
     int     i;
 
     bestspot = NULL;
     bestdistance = 0;
     for (i = 0; i < level.numspawns; i++) {
-        spot = level.spawns[i];
-        bestplayerdistance = PlayersRangeFromSpot(spot);
-        if (bestplayerdistance > bestdistance) {
-            bestspot = spot;
-            bestdistance = bestplayerdistance;
+        if (ranges[i] > bestdistance) {
+            bestspot = level.spawns[i];
+            bestdistance = ranges[i];
         }
     }
 
@@ -861,6 +991,75 @@ static edict_t *SelectFarthestDeathmatchSpawnPoint(void)
     return level.spawns[0];
 }
 
+/*
+================
+SelectRandomDeathmatchSpawnPointOutOfSight
+
+go to a random point that can't see any living player, using precomputed
+line of sight between spawn points and major items. each player is assumed
+to stand at the nearest spawn point or item.
+================
+*/
+static edict_t *SelectRandomDeathmatchSpawnPointOutOfSight(void)
+{
+    edict_t *spots[MAX_SPAWNS];
+    uint64_t spawns_seen, items_seen;
+    vec3_t  v;
+    float   dist, bestdist;
+    int     i, n, best, count;
+
+    if (!level.spawn_vis.done) {
+        return SelectRandomDeathmatchSpawnPointAvoidingTwoClosest();
+    }
+
+    // update player origins and distances
+    SpawnRanges();
+
+    spawns_seen = items_seen = 0;
+    for (n = 0; n < game.maxclients; n++) {
+        if (!level.spawn_cache.alive[n])
+            continue;
+
+        best = 0;
+        bestdist = 9999999;
+        for (i = 0; i < level.numspawns; i++) {
+            if (level.spawn_cache.dists[n][i] < bestdist) {
+                bestdist = level.spawn_cache.dists[n][i];
+                best = i;
+            }
+        }
+
+        for (i = 0; i < level.spawn_vis.numitems; i++) {
+            VectorSubtract(level.spawn_vis.items[i], level.spawn_cache.origins[n], v);
+            dist = VectorLength(v);
+            if (dist < bestdist) {
+                bestdist = dist;
+                best = level.numspawns + i;
+            }
+        }
+
+        if (best < level.numspawns)
+            spawns_seen |= 1ULL << best;
+        else
+            items_seen |= 1ULL << (best - level.numspawns);
+    }
+
+    count = 0;
+    for (i = 0; i < level.numspawns; i++) {
+        if (level.spawn_vis.spawns_seen[i] & spawns_seen)
+            continue;
+        if (level.spawn_vis.items_seen[i] & items_seen)
+            continue;
+        spots[count++] = level.spawns[i];
+    }
+
+    if (!count) {
+        return SelectRandomDeathmatchSpawnPointAvoidingTwoClosest();
+    }
+
+    return spots[Q_rand_uniform(count)];
+}
+
 static edict_t *SelectDeathmatchSpawnPoint(void)
 {
     // in the first 5 seconds of a level start,
@@ -881,6 +1080,9 @@ static edict_t *SelectDeathmatchSpawnPoint(void)
         if ((int)g_spawn_mode->value == 1) {
             return SelectRandomDeathmatchSpawnPointAvoidingTwoClosest();
         }
+        if ((int)g_spawn_mode->value == 3) {
+            return SelectRandomDeathmatchSpawnPointOutOfSight();
+        }
     }
     return SelectRandomDeathmatchSpawnPoint();
 }
@@ -998,6 +1200,7 @@ static void CopyToBodyQue(edict_t *ent)
     body->owner = ent->owner;
     body->movetype = ent->movetype;
     body->groundentity = ent->groundentity;
+    G_WakeEntity(body);
 
     body->die = body_die;
     body->takedamage = DAMAGE_YES;
@@ -1054,6 +1257,8 @@ void spectator_respawn(edict_t *ent, int connected)
 
         TossClientWeapon(ent);
 
+        // credit pending damage before statistics are logged and cleared
+        G_FlushDamage();
         G_LogClient(ent->client);
 
         // clear client on respawn
@@ -1509,6 +1714,7 @@ void ClientUserinfoChanged(edict_t *ent, char *userinfo)
             gi.configstring(CS_PLAYERNAMES + playernum, name);
             strcpy(client->pers.skin, skin);
             strcpy(client->pers.netname, name);
+            G_DirtyScoreboard();
         }
     }
 
@@ -1625,9 +1831,13 @@ void ClientDisconnect(edict_t *ent)
     if (!ent->client)
         return;
 
+    // credit pending damage while both sides are still around
+    G_FlushDamage();
+
     connected = ent->client->pers.connected;
     ent->client->pers.connected = CONN_DISCONNECTED;
     ent->client->ps.stats[STAT_FRAGS] = 0;
+    ent->client->level.dirty_strings = 0;
 
     if (connected == CONN_SPAWNED) {
         G_LogClient(ent->client);
@@ -1699,20 +1909,57 @@ G_TouchProjectiles
 An ugly hack that runs a trace against any FL_NOCLIP_PROJECTILE entities
 for clipping purposes against players. This assumes that the ent
 will be freed on touch or bad things will happen.
+
+Traces are skipped unless such projectiles exist and one of them is
+linked within the bounds swept by the move.
 ==============
 */
+static bool G_ProjectilesNear(edict_t *ent, vec3_t start)
+{
+    static edict_t *touch[MAX_EDICTS];
+    vec3_t mins, maxs;
+    int i, num;
+
+    if (!level.noclip_projectiles) {
+        return false;
+    }
+
+    for (i = 0; i < 3; i++) {
+        mins[i] = min(start[i], ent->s.origin[i]) + ent->mins[i];
+        maxs[i] = max(start[i], ent->s.origin[i]) + ent->maxs[i];
+    }
+
+    num = gi.BoxEdicts(mins, maxs, touch, MAX_EDICTS, AREA_SOLID);
+    for (i = 0; i < num; i++) {
+        if (touch[i]->flags & FL_NOCLIP_PROJECTILE) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static void G_TouchProjectiles(edict_t *ent, vec3_t start)
 {
     edict_t *ignore;
     trace_t tr;
     int i;
 
+    if (!G_ProjectilesNear(ent, start)) {
+        level.perf.projectile_avoided += 10;
+        return;
+    }
+
     ignore = ent;
     for (i = 0; i < 10; i++) {
         tr = gi.trace(start, ent->mins, ent->maxs, ent->s.origin,
                       ignore, CONTENTS_MONSTER | CONTENTS_DEADMONSTER);
-        if (!tr.ent || tr.ent == world)
-            continue;
+        level.perf.projectile_traces++;
+        if (!tr.ent || tr.ent == world) {
+            // tracing again would give the same result
+            level.perf.projectile_avoided += 9 - i;
+            break;
+        }
         VectorCopy(tr.endpos, start);
         ignore = tr.ent;
 
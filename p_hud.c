@@ -40,51 +40,90 @@ static int G_PlayerCmp(const void *p1, const void *p2)
     return r;
 }
 
+// rank order kept across calls, so that only clients whose
+// score has changed need to be moved
+static gclient_t    *rankorder[MAX_CLIENTS];
+static bool         ranked[MAX_CLIENTS];
+static int          numranked;
+
 int G_CalcRanks(gclient_t **ranks)
 {
-    int i, total;
+    gclient_t *c;
+    int i, j;
+
+    // drop clients no longer in game
+    for (i = j = 0; i < numranked; i++) {
+        c = rankorder[i];
+        if (c->pers.connected == CONN_SPAWNED) {
+            rankorder[j++] = c;
+        } else {
+            ranked[c - game.clients] = false;
+            c->level.rank = 0;
+        }
+    }
+    numranked = j;
 
-    // sort the clients by score, then by eff
-    total = 0;
+    // add new ones
     for (i = 0; i < game.maxclients; i++) {
-        if (game.clients[i].pers.connected == CONN_SPAWNED) {
-            if (ranks) {
-                ranks[total] = &game.clients[i];
-            }
-            total++;
+        if (!ranked[i] && game.clients[i].pers.connected == CONN_SPAWNED) {
+            rankorder[numranked++] = &game.clients[i];
+            ranked[i] = true;
+        }
+    }
+
+    // sort the clients by score, then by deaths
+    for (i = 1; i < numranked; i++) {
+        c = rankorder[i];
+        for (j = i; j > 0 && G_PlayerCmp(&rankorder[j - 1], &c) > 0; j--) {
+            rankorder[j] = rankorder[j - 1];
+            level.perf.rank_moves++;
         }
+        rankorder[j] = c;
     }
 
     if (ranks) {
-        qsort(ranks, total, sizeof(gclient_t *), G_PlayerCmp);
+        memcpy(ranks, rankorder, numranked * sizeof(ranks[0]));
     }
 
-    return total;
+    return numranked;
 }
 
 
-/*
-==================
-BuildDeathmatchScoreboard
+// rows shared by all viewers, rebuilt once per frame or when changed
+static struct {
+    unsigned    version;
+    unsigned    built_version;
+    int         built_framenum;
+    int         numelems;
+    size_t      ends[MAX_CLIENTS + 2];      // end offset of each element
+    int         owners[MAX_CLIENTS + 2];    // spectator highlighted for, or -1
+    size_t      marks[MAX_CLIENTS + 2];     // offset of highlight character
+    char        text[MAX_NET_STRING];
+} scoreboard;
 
-Used to update per-client scoreboard and build
-global oldscores (client is NULL in the latter case).
-==================
-*/
+void G_DirtyScoreboard(void)
+{
+    scoreboard.version++;
+}
 
-#define APPEND(...) do {                            \
-        len = Q_snprintf(text, size, __VA_ARGS__);  \
-        if (len >= size)                            \
-            goto done;                              \
-        text += len;                                \
-        size -= len;                                \
-    } while (0)
+// records element that was just written, drops it if it didn't fit
+static bool EndElement(layout_buf_t *l, size_t start, int owner)
+{
+    if (l->overflowed) {
+        G_LayoutRewind(l, start);
+        return false;
+    }
 
-static void BuildDeathmatchScoreboard(char *text, gclient_t *client)
+    scoreboard.owners[scoreboard.numelems] = owner;
+    scoreboard.ends[scoreboard.numelems++] = l->len;
+    return true;
+}
+
+static void UpdateScoreboard(void)
 {
     char    status[MAX_QPATH];
-    size_t  size = MAX_STRING_CHARS;
-    size_t  len;
+    layout_buf_t    lay;
+    size_t  start;
     int     i, j, numranks;
     int     y, sec, eff;
     gclient_t   *ranks[MAX_CLIENTS];
@@ -93,25 +132,31 @@ static void BuildDeathmatchScoreboard(char *text, gclient_t *client)
     struct tm   *tm;
     const char  *s;
 
-    if (client && client->pers.extended_layout && (client->pers.uf & UF_EXTENDED_LAYOUT))
-        size = MAX_NET_STRING;
+    if (scoreboard.built_version == scoreboard.version &&
+        scoreboard.built_framenum == level.framenum && scoreboard.numelems) {
+        return;
+    }
 
-    APPEND("xv 0 ");
+    scoreboard.built_version = scoreboard.version;
+    scoreboard.built_framenum = level.framenum;
+    scoreboard.numelems = 0;
+    level.perf.scoreboard_builds++;
 
-    if (!client)
-        APPEND("yv 10 cstring2 \"Old scoreboard from %s\"", level.mapname);
+    G_LayoutInit(&lay, scoreboard.text, sizeof(scoreboard.text));
 
     t = time(NULL);
     tm = localtime(&t);
     if (!tm || !strftime(status, sizeof(status), "[%Y-%m-%d %H:%M]", tm))
         strcpy(status, "???");
 
-    APPEND("yv 18 "
-           "cstring \"%s\""
-           "xv -16 "
-           "yv 26 "
-           "string \"Player          Frg Dth Eff%% FPH Time Ping\""
-           "xv -40 ", status);
+    G_LayoutCoord(&lay, "yv", 18);
+    G_LayoutString(&lay, "cstring", "%s", status);
+    G_LayoutCoord(&lay, "xv", -16);
+    G_LayoutCoord(&lay, "yv", 26);
+    G_LayoutString(&lay, "string", "Player          Frg Dth Eff%% FPH Time Ping");
+    G_LayoutCoord(&lay, "xv", -40);
+    if (!EndElement(&lay, 0, -1))
+        return;
 
     numranks = G_CalcRanks(ranks);
 
@@ -144,10 +189,13 @@ static void BuildDeathmatchScoreboard(char *text, gclient_t *client)
             s = "";
         }
 
-        APPEND("yv %d string%s \"%2d %-15s %3d %3d %3d %4d %4s %4d%s\"",
-               y, c == client ? "2" : "2", i + 1,
-               c->pers.netname, c->resp.score, c->resp.deaths, eff,
-               c->resp.score * 3600 / sec, status, c->ping, s);
+        start = lay.len;
+        G_LayoutCoord(&lay, "yv", y);
+        G_LayoutString(&lay, "string2", "%2d %-15s %3d %3d %3d %4d %4s %4d%s",
+                       i + 1, c->pers.netname, c->resp.score, c->resp.deaths, eff,
+                       c->resp.score * 3600 / sec, status, c->ping, s);
+        if (!EndElement(&lay, start, -1))
+            return;
         y += 8;
     }
 
@@ -175,18 +223,74 @@ static void BuildDeathmatchScoreboard(char *text, gclient_t *client)
             strcpy(status, "(observing)");
         }
 
-        APPEND("yv %d string%s \"   %-15s %-18s%3d %4d\"",
-               y, c == client ? "" : "2",
-               c->pers.netname, status, sec / 60, c->ping);
+        start = lay.len;
+        G_LayoutCoord(&lay, "yv", y);
+
+        // own row is highlighted by dropping '2' from "string2"
+        scoreboard.marks[scoreboard.numelems] = lay.len + 6;
+
+        G_LayoutString(&lay, "string2", "   %-15s %-18s%3d %4d",
+                       c->pers.netname, status, sec / 60, c->ping);
+        if (!EndElement(&lay, start, i))
+            return;
         y += 8;
     }
 
     // add server info
-    if (sv_hostname && sv_hostname->string[0])
-        APPEND("xl 8 yb -37 string2 \"%s\"", sv_hostname->string);
+    if (sv_hostname && sv_hostname->string[0]) {
+        start = lay.len;
+        G_LayoutCoord(&lay, "xl", 8);
+        G_LayoutCoord(&lay, "yb", -37);
+        G_LayoutString(&lay, "string2", "%s", sv_hostname->string);
+        EndElement(&lay, start, -1);
+    }
+}
+
+/*
+==================
+BuildDeathmatchScoreboard
+
+Used to update per-client scoreboard and build
+global oldscores (client is NULL in the latter case).
+Shared rows are copied up to the layout size limit of the client,
+patching the highlight of its own row.
+==================
+*/
+static void BuildDeathmatchScoreboard(char *text, gclient_t *client)
+{
+    layout_buf_t    lay;
+    size_t      size = MAX_STRING_CHARS;
+    size_t      start, end, mark, len;
+    int         i;
+
+    if (client && client->pers.extended_layout && (client->pers.uf & UF_EXTENDED_LAYOUT))
+        size = MAX_NET_STRING;
+
+    G_LayoutInit(&lay, text, size);
+    G_LayoutCoord(&lay, "xv", 0);
+
+    if (!client) {
+        G_LayoutCoord(&lay, "yv", 10);
+        G_LayoutString(&lay, "cstring2", "Old scoreboard from %s", level.mapname);
+    }
 
-done:
-    *text = 0;
+    UpdateScoreboard();
+
+    for (i = 0, start = 0; i < scoreboard.numelems; i++, start = end) {
+        end = scoreboard.ends[i];
+        len = lay.len;
+        if (client && scoreboard.owners[i] == client - game.clients) {
+            mark = scoreboard.marks[i];
+            G_LayoutCopy(&lay, scoreboard.text + start, mark - start);
+            G_LayoutCopy(&lay, scoreboard.text + mark + 1, end - mark - 1);
+        } else {
+            G_LayoutCopy(&lay, scoreboard.text + start, end - start);
+        }
+        if (lay.overflowed) {
+            G_LayoutRewind(&lay, len);
+            break;
+        }
+    }
 }
 
 /*
@@ -200,38 +304,38 @@ void HighScoresMessage(void)
 {
     char    string[MAX_STRING_CHARS];
     char    date[MAX_QPATH];
+    layout_buf_t    lay;
     struct tm   *tm;
     score_t *s;
-    char    *text = string;
-    size_t  size = sizeof(string);
-    size_t  len;
+    size_t  start;
     int     i;
     int     y;
 
-    APPEND("xv 0 "
-           "yv 0 "
-           "cstring \"High Scores for %s\""
-           "yv 16 "
-           "cstring2 \"  # Name             FPH Date      \"",
-           level.mapname);
+    G_LayoutInit(&lay, string, sizeof(string));
+    G_LayoutCoord(&lay, "xv", 0);
+    G_LayoutCoord(&lay, "yv", 0);
+    G_LayoutString(&lay, "cstring", "High Scores for %s", level.mapname);
+    G_LayoutCoord(&lay, "yv", 16);
+    G_LayoutString(&lay, "cstring2", "  # Name             FPH Date      ");
 
     y = 24;
-    for (i = 0; i < level.numscores; i++) {
+    for (i = 0; i < level.numscores && !lay.overflowed; i++) {
         s = &level.scores[i];
 
         tm = localtime(&s->time);
         if (!tm || !strftime(date, sizeof(date), "%Y-%m-%d", tm))
             strcpy(date, "???");
 
-        APPEND("yv %d cstring \"%c%2d %-15.15s %4d %-10s\"",
-               y, s->time == level.record ? '*' : ' ',
-               i + 1, s->name, s->score, date);
+        start = lay.len;
+        G_LayoutCoord(&lay, "yv", y);
+        G_LayoutString(&lay, "cstring", "%c%2d %-15.15s %4d %-10s",
+                       s->time == level.record ? '*' : ' ',
+                       i + 1, s->name, s->score, date);
+        if (lay.overflowed)
+            G_LayoutRewind(&lay, start);
         y += 8;
     }
 
-done:
-    *text = 0;
-
     gi.WriteByte(svc_layout);
     gi.WriteString(string);
     gi.multicast(NULL, MULTICAST_ALL_R);
@@ -251,6 +355,7 @@ void DeathmatchScoreboardMessage(edict_t *ent, bool reliable)
     char buffer[MAX_NET_STRING];
 
     BuildDeathmatchScoreboard(buffer, ent->client);
+    level.perf.scoreboard_sends++;
 
     gi.WriteByte(svc_layout);
     gi.WriteString(buffer);
@@ -330,6 +435,8 @@ void BeginIntermission(void)
     level.intermission_framenum = level.framenum;
     level.match_state = MS_INTERMISSION;
 
+    G_FlushDamage();
+
     G_FinishVote();
 
     BuildDeathmatchScoreboard(game.oldscores, NULL);
@@ -378,9 +485,6 @@ void BeginIntermission(void)
 
 void G_PrivateString(edict_t *ent, int index, const char *string)
 {
-    gclient_t *client;
-    int i;
-
     if (index < 0 || index >= PCS_TOTAL) {
         gi.error("%s: index %d out of range", __func__, index);
     }
@@ -389,25 +493,70 @@ void G_PrivateString(edict_t *ent, int index, const char *string)
         return; // not changed
     }
 
-    // save new string
+    // save new string, it will be sent at the end of frame
     Q_strlcpy(ent->client->level.strings[index], string, MAX_NETNAME);
+    ent->client->level.dirty_strings |= 1 << index;
+}
 
-    gi.WriteByte(svc_configstring);
-    gi.WriteShort(CS_PRIVATE + index);
-    gi.WriteString(string);
-    gi.unicast(ent, true);
+/*
+=============
+G_FlushPrivateStrings
 
-    // send it to chasecam clients too
-    if (ent->client->chase_target) {
-        return;
+Copies changed private configstrings to chasecam clients, then sends
+all changed strings of each client in a single message.
+=============
+*/
+void G_FlushPrivateStrings(void)
+{
+    edict_t     *chasers[MAX_CLIENTS];
+    gclient_t   *client, *other;
+    int         i, j, k, count;
+
+    for (i = 0, client = game.clients; i < game.maxclients; i++, client++) {
+        if (client->pers.connected <= CONN_CONNECTED) {
+            continue;
+        }
+        if (!client->level.dirty_strings || client->chase_target) {
+            continue;
+        }
+        count = G_GetChasers(client->edict, chasers);
+        for (j = 0; j < count; j++) {
+            other = chasers[j]->client;
+            if (other->pers.connected <= CONN_CONNECTED) {
+                continue;
+            }
+            for (k = 0; k < PCS_TOTAL; k++) {
+                if (!(client->level.dirty_strings & (1 << k))) {
+                    continue;
+                }
+                if (!strcmp(other->level.strings[k], client->level.strings[k])) {
+                    continue;
+                }
+                Q_strlcpy(other->level.strings[k], client->level.strings[k], MAX_NETNAME);
+                other->level.dirty_strings |= 1 << k;
+            }
+        }
     }
+
     for (i = 0, client = game.clients; i < game.maxclients; i++, client++) {
-        if (client->pers.connected != CONN_SPECTATOR) {
+        if (client->pers.connected <= CONN_CONNECTED) {
+            continue;
+        }
+        if (!client->level.dirty_strings) {
             continue;
         }
-        if (client->chase_target == ent) {
-            G_PrivateString(client->edict, index, string);
+        for (k = 0; k < PCS_TOTAL; k++) {
+            if (!(client->level.dirty_strings & (1 << k))) {
+                continue;
+            }
+            gi.WriteByte(svc_configstring);
+            gi.WriteShort(CS_PRIVATE + k);
+            gi.WriteString(client->level.strings[k]);
+            level.perf.private_strings++;
         }
+        gi.unicast(client->edict, true);
+        level.perf.private_unicasts++;
+        client->level.dirty_strings = 0;
     }
 }
 
@@ -431,8 +580,12 @@ static bool visible(edict_t *self, edict_t *other, int mask)
     VectorCopy(other->s.origin, spot2);
     spot2[2] += other->viewheight;
 
+    if (!gi.inPVS(spot1, spot2))
+        return false;
+
     for (i = 0; i < 10; i++) {
         trace = gi.trace(spot1, vec3_origin, vec3_origin, spot2, self, mask);
+        level.perf.viewid_traces++;
 
         if (trace.fraction == 1.0f)
             return true;
@@ -456,6 +609,46 @@ static bool visible(edict_t *self, edict_t *other, int mask)
     return false;
 }
 
+/*
+=============
+players_visible
+
+returns true if both players can see each other. results are shared by
+both directions and all callers until g_viewid_refresh frames pass.
+=============
+*/
+static bool players_visible(edict_t *a, edict_t *b)
+{
+    int         i = a - g_edicts - 1;
+    int         j = b - g_edicts - 1;
+    int         refresh = max((int)g_viewid_refresh->value, 1);
+    unsigned    *entry;
+    bool        result;
+
+    if (level.framenum < game.visframenum ||
+        level.framenum >= game.visframenum + refresh) {
+        game.visframenum = level.framenum;
+        game.visgen++;
+    }
+
+    if (i > j)
+        entry = &game.viscache[j * game.maxclients + i];
+    else
+        entry = &game.viscache[i * game.maxclients + j];
+
+    if ((*entry >> 1) == game.visgen) {
+        level.perf.viewid_cached++;
+        return *entry & 1;
+    }
+
+    // note, we trace twice so we hit water planes
+    result = visible(a, b, CONTENTS_SOLID | MASK_WATER) &&
+             visible(b, a, CONTENTS_SOLID | MASK_WATER);
+
+    *entry = game.visgen << 1 | result;
+    return result;
+}
+
 /*
 ==============
 TDM_GetPlayerIdView
@@ -478,7 +671,7 @@ static edict_t *find_by_tracing(edict_t *ent)
     VectorCopy(ent->s.origin, start);
     start[2] += ent->viewheight;
 
-    AngleVectors(ent->client->v_angle, forward, NULL, NULL);
+    G_ViewVectors(ent->client, forward, NULL, NULL);
 
     VectorScale(forward, 4096, forward);
     VectorAdd(ent->s.origin, forward, forward);
@@ -509,9 +702,8 @@ static edict_t *find_by_tracing(edict_t *ent)
             break;
 
         // we hit something that's a player and it's alive!
-        // note, we trace twice so we hit water planes
         if (tr.ent && tr.ent->client && tr.ent->health > 0 &&
-            visible(tr.ent, ent, CONTENTS_SOLID | MASK_WATER)) {
+            players_visible(tr.ent, ent)) {
             return tr.ent;
         }
 
@@ -530,7 +722,7 @@ static edict_t *find_by_angles(edict_t *ent)
     float       distance, bdistance = 0.0f;
     float       bd = 0.0f, d;
 
-    AngleVectors(ent->client->v_angle, forward, NULL, NULL);
+    G_ViewVectors(ent->client, forward, NULL, NULL);
     best = NULL;
 
     // if trace was unsuccessful, try guessing based on angles
@@ -551,10 +743,7 @@ static edict_t *find_by_angles(edict_t *ent)
         VectorNormalize(dir);
         d = DotProduct(forward, dir);
 
-        // note, we trace twice so we hit water planes
-        if (d > bd &&
-            visible(ent, who, CONTENTS_SOLID | MASK_WATER) &&
-            visible(who, ent, CONTENTS_SOLID | MASK_WATER)) {
+        if (d > bd && players_visible(ent, who)) {
             bdistance = distance;
             bd = d;
             best = who;
@@ -576,16 +765,54 @@ static edict_t *find_by_angles(edict_t *ent)
     return NULL;
 }
 
+// hysteresis: looser than any of the slops above
+static bool keep_target(edict_t *ent, edict_t *target)
+{
+    vec3_t      forward;
+    vec3_t      dir;
+
+    if (!target->inuse || !PlayerSpawned(target) || target->health <= 0)
+        return false;
+
+    G_ViewVectors(ent->client, forward, NULL, NULL);
+    VectorSubtract(target->s.origin, ent->s.origin, dir);
+    VectorNormalize(dir);
+    if (DotProduct(forward, dir) < 0.5f)
+        return false;
+
+    return players_visible(ent, target);
+}
+
+/*
+==============
+G_GetPlayerIdView
+
+Full search is done once per g_viewid_interval frames for each client,
+staggered by client number. In between, the previous target is kept
+while it stays visible.
+==============
+*/
 int G_GetPlayerIdView(edict_t *ent)
 {
-    edict_t *target;
+    gclient_t   *client = ent->client;
+    int         interval = max((int)g_viewid_interval->value, 1);
+    edict_t     *target;
+
+    if ((level.framenum + client->clientNum) % interval) {
+        target = client->viewid_target;
+        if (target && !keep_target(ent, target))
+            target = NULL;
+        level.perf.viewid_skipped++;
+    } else {
+        target = find_by_tracing(ent);
+        if (!target)
+            target = find_by_angles(ent);
+        level.perf.viewid_evals++;
+    }
 
-    target = find_by_tracing(ent);
+    client->viewid_target = target;
     if (!target) {
-        target = find_by_angles(ent);
-        if (!target) {
-            return 0;
-        }
+        return 0;
     }
 
     return CS_PLAYERNAMES + (target - g_edicts) - 1;
@@ -618,7 +845,7 @@ void G_SetStats(edict_t *ent)
         ent->client->ps.stats[STAT_AMMO] = 0;
     } else {
         item = INDEX_ITEM(ent->client->ammo_index);
-        ent->client->ps.stats[STAT_AMMO_ICON] = gi.imageindex(item->icon);
+        ent->client->ps.stats[STAT_AMMO_ICON] = ItemIconIndex(item);
         ent->client->ps.stats[STAT_AMMO] = ent->client->inventory[ent->client->ammo_index];
     }
 
@@ -632,7 +859,7 @@ void G_SetStats(edict_t *ent)
         if (cells == 0) {
             // ran out of cells for power armor
             ent->flags &= ~FL_POWER_ARMOR;
-            gi.sound(ent, CHAN_ITEM, gi.soundindex("misc/power2.wav"), 1, ATTN_NORM, 0);
+            gi.sound(ent, CHAN_ITEM, PowerArmorSoundIndex(), 1, ATTN_NORM, 0);
             power_armor_type = 0;
         }
     }
@@ -644,7 +871,7 @@ void G_SetStats(edict_t *ent)
         ent->client->ps.stats[STAT_ARMOR] = cells;
     } else if (index) {
         item = INDEX_ITEM(index);
-        ent->client->ps.stats[STAT_ARMOR_ICON] = gi.imageindex(item->icon);
+        ent->client->ps.stats[STAT_ARMOR_ICON] = ItemIconIndex(item);
         ent->client->ps.stats[STAT_ARMOR] = ent->client->inventory[index];
     } else {
         ent->client->ps.stats[STAT_ARMOR_ICON] = 0;
@@ -698,7 +925,7 @@ void G_SetStats(edict_t *ent)
         ent->client->ps.stats[STAT_SELECTED_ICON] = 0;
     } else {
         item = INDEX_ITEM(ent->client->selected_item);
-        ent->client->ps.stats[STAT_SELECTED_ICON] = gi.imageindex(item->icon);
+        ent->client->ps.stats[STAT_SELECTED_ICON] = ItemIconIndex(item);
     }
 
     ent->client->ps.stats[STAT_SELECTED_ITEM] = ent->client->selected_item;
@@ -720,7 +947,7 @@ void G_SetStats(edict_t *ent)
     // help icon / current weapon if not shown
     //
     if ((ent->client->pers.hand == CENTER_HANDED || ent->client->ps.fov > 91) && ent->client->weapon)
-        ent->client->ps.stats[STAT_HELPICON] = gi.imageindex(ent->client->weapon->icon);
+        ent->client->ps.stats[STAT_HELPICON] = ItemIconIndex(ent->client->weapon);
     else
         ent->client->ps.stats[STAT_HELPICON] = 0;
 
@@ -19,58 +19,83 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 #include "g_local.h"
 
-static void PMenu_Write(edict_t *ent)
+// min time between menu layouts sent to a client
+#define MENU_UPDATE_FRAMES  max(HZ / 10, 1)
+
+#define ALL_ENTRIES ((1U << MAX_MENU_ENTRIES) - 1)
+
+static const char menu_frame[] = "xv 32 yv 8 picn inventory ";
+
+static void PMenu_RenderEntry(pmenu_t *menu, int i)
+{
+    layout_buf_t lay;
+    pmenu_entry_t *p = &menu->entries[i];
+    const char *t;
+    bool alt;
+    int x;
+
+    G_LayoutInit(&lay, menu->layout[i], sizeof(menu->layout[i]));
+
+    if (!p->text || !p->text[0])
+        return; // blank line
+    t = p->text;
+    if (*t == '*') {
+        alt = true;
+        t++;
+    } else {
+        alt = false;
+    }
+    if (p->align == PMENU_ALIGN_CENTER)
+        x = 196 / 2 - strlen(t) * 4 + 64;
+    else if (p->align == PMENU_ALIGN_RIGHT)
+        x = 64 + (196 - strlen(t) * 8);
+    else
+        x = 64;
+
+    if (menu->cur == i) {
+        x -= 8;
+        alt ^= 1;
+    }
+
+    G_LayoutCoord(&lay, "yv", 32 + i * 8);
+    G_LayoutCoord(&lay, "xv", x);
+    G_LayoutString(&lay, alt ? "string2" : "string", "%s%s",
+                   menu->cur == i ? "\x0d" : "", t);
+    G_LayoutCopy(&lay, " ", 1);
+    if (lay.overflowed) {
+        gi.dprintf("%s: entry %d too long: %s\n", __func__, i, p->text);
+        G_LayoutRewind(&lay, 0);
+    }
+
+    level.perf.menu_entries++;
+}
+
+static size_t PMenu_Write(edict_t *ent)
 {
     char string[MAX_STRING_CHARS];
-    char entry[MAX_STRING_CHARS];
+    layout_buf_t lay;
     int i;
-    size_t total, len;
-    pmenu_entry_t *p;
-    int x;
     pmenu_t *menu = &ent->client->menu;
-    const char *t;
-    bool alt;
 
-    strcpy(string, "xv 32 yv 8 picn inventory ");
-    total = strlen(string);
+    // only entries that have changed are rendered again
+    for (i = 0; i < MAX_MENU_ENTRIES; i++) {
+        if (menu->dirty & (1U << i))
+            PMenu_RenderEntry(menu, i);
+    }
+    menu->dirty = 0;
 
-    for (i = 0, p = menu->entries; i < MAX_MENU_ENTRIES; i++, p++) {
-        if (!p->text || !p->text[0])
-            continue; // blank line
-        t = p->text;
-        if (*t == '*') {
-            alt = true;
-            t++;
-        } else {
-            alt = false;
-        }
-        if (p->align == PMENU_ALIGN_CENTER)
-            x = 196 / 2 - strlen(t) * 4 + 64;
-        else if (p->align == PMENU_ALIGN_RIGHT)
-            x = 64 + (196 - strlen(t) * 8);
-        else
-            x = 64;
-
-        if (menu->cur == i) {
-            x -= 8;
-            alt ^= 1;
-        }
+    G_LayoutInit(&lay, string, sizeof(string));
+    G_LayoutCopy(&lay, menu_frame, sizeof(menu_frame) - 1);
 
-        len = Q_snprintf(entry, sizeof(entry), "yv %d xv %d string%s \"%s%s\" ",
-                         32 + i * 8, x, alt ? "2" : "", menu->cur == i ? "\x0d" : "", t);
-        if (len >= sizeof(entry)) {
-            continue;
-        }
-        if (total + len >= MAX_STRING_CHARS)
+    for (i = 0; i < MAX_MENU_ENTRIES; i++) {
+        G_LayoutCopy(&lay, menu->layout[i], strlen(menu->layout[i]));
+        if (lay.overflowed)
             break;
-        memcpy(string + total, entry, len);
-        total += len;
     }
 
-    string[total] = 0;
-
     gi.WriteByte(svc_layout);
     gi.WriteString(string);
+    return lay.len;
 }
 
 void PMenu_Open(edict_t *ent, const pmenu_entry_t *entries)
@@ -95,8 +120,9 @@ void PMenu_Open(edict_t *ent, const pmenu_entry_t *entries)
         }
     }
 
-    //ent->client->menu_framenum = 0;
-    ent->client->menu_dirty = true;
+    menu->dirty = ALL_ENTRIES;
+    ent->client->menu_dirty++;
+    ent->client->menu_framenum = 0;
     ent->client->layout = LAYOUT_MENU;
 }
 
@@ -106,29 +132,37 @@ void PMenu_Close(edict_t *ent)
         return;
     }
     memset(&ent->client->menu, 0, sizeof(ent->client->menu));
-    ent->client->menu_dirty = false;
+    ent->client->menu_dirty = 0;
+    ent->client->menu_framenum = 0;
     ent->client->layout = LAYOUT_NONE;
 }
 
 void PMenu_Update(edict_t *ent)
 {
-    if (ent->client->layout != LAYOUT_MENU) {
+    gclient_t *client = ent->client;
+    size_t len;
+
+    if (client->layout != LAYOUT_MENU) {
         return;
     }
 
-    if (!ent->client->menu_dirty) {
+    if (!client->menu_dirty) {
         return;
     }
 
-    //if (level.framenum - ent->client->menu_framenum < 1*HZ ) {
-    //return;
-    //}
+    // changes made until then are sent together
+    if (level.framenum - client->menu_framenum < MENU_UPDATE_FRAMES) {
+        return;
+    }
 
-    // been a second or more since last update, update now
-    PMenu_Write(ent);
+    len = PMenu_Write(ent);
     gi.unicast(ent, true);
-    //ent->client->menu_framenum = level.framenum;
-    ent->client->menu_dirty = false;
+
+    level.perf.menu_bytes += len;
+    level.perf.menu_bytes_saved += (client->menu_dirty - 1) * len;
+
+    client->menu_framenum = level.framenum;
+    client->menu_dirty = 0;
 }
 
 void PMenu_Next(edict_t *ent)
@@ -156,9 +190,10 @@ void PMenu_Next(edict_t *ent)
             break;
     } while (i != menu->cur);
 
+    menu->dirty |= 1U << menu->cur | 1U << i;
     menu->cur = i;
 
-    ent->client->menu_dirty = true;
+    ent->client->menu_dirty++;
 }
 
 void PMenu_Prev(edict_t *ent)
@@ -189,9 +224,10 @@ void PMenu_Prev(edict_t *ent)
             break;
     } while (i != menu->cur);
 
+    menu->dirty |= 1U << menu->cur | 1U << i;
     menu->cur = i;
 
-    ent->client->menu_dirty = true;
+    ent->client->menu_dirty++;
 }
 
 void PMenu_Select(edict_t *ent)
@@ -950,7 +950,7 @@ void ClientEndServerFrame(edict_t *ent)
         ent->client->ps.pmove.velocity[i] = COORD2SHORT(ent->velocity[i]);
     }
 
-    AngleVectors(ent->client->v_angle, forward, right, up);
+    G_ViewVectors(ent->client, forward, right, up);
 
     // burn from lava, etc
     P_WorldEffects();
@@ -289,6 +289,21 @@ void Drop_Weapon(edict_t *ent, gitem_t *item)
 }
 
 
+// frame sets are bitmasks, frames past 63 can't be in them
+#define F(n)                    (1ULL << (n))
+#define F_RANGE(a, b)           ((F(b) << 1) - F(a))
+#define FRAME_IN(set, n)        ((unsigned)(n) < 64 && ((set) >> (n)) & 1)
+
+typedef struct {
+    int         activate_last;
+    int         fire_last;
+    int         idle_last;
+    int         deactivate_last;
+    uint64_t    pause_frames;   // idle frames that may pause animation
+    uint64_t    fire_frames;    // frames fire function is called at
+    void        (*fire)(edict_t *ent);
+} weapon_frames_t;
+
 /*
 ================
 Weapon_Generic
@@ -296,23 +311,17 @@ Weapon_Generic
 A generic function to handle the basics of weapon thinking
 ================
 */
-#define FRAME_FIRE_FIRST        (FRAME_ACTIVATE_LAST + 1)
-#define FRAME_IDLE_FIRST        (FRAME_FIRE_LAST + 1)
-#define FRAME_DEACTIVATE_FIRST  (FRAME_IDLE_LAST + 1)
-
-static void Weapon_Generic(edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE_LAST, int FRAME_IDLE_LAST, int FRAME_DEACTIVATE_LAST, const int *pause_frames, const int *fire_frames, void (*fire)(edict_t *ent))
+static void Weapon_Generic(edict_t *ent, const weapon_frames_t *w)
 {
-    int     n;
-
     if (ent->deadflag || ent->s.modelindex != 255) { // VWep animations screw up corpses
         return;
     }
 
     if (ent->client->weaponstate == WEAPON_DROPPING) {
-        if (ent->client->weaponframe == FRAME_DEACTIVATE_LAST) {
+        if (ent->client->weaponframe == w->deactivate_last) {
             ChangeWeapon(ent);
             return;
-        } else if ((FRAME_DEACTIVATE_LAST - ent->client->weaponframe) == 4) {
+        } else if ((w->deactivate_last - ent->client->weaponframe) == 4) {
             ent->client->anim_priority = ANIM_REVERSE;
             if (ent->client->ps.pmove.pm_flags & PMF_DUCKED) {
                 ent->client->anim_start = FRAME_crpain4;
@@ -329,9 +338,9 @@ static void Weapon_Generic(edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE
     }
 
     if (ent->client->weaponstate == WEAPON_ACTIVATING) {
-        if (ent->client->weaponframe == FRAME_ACTIVATE_LAST) {
+        if (ent->client->weaponframe == w->activate_last) {
             ent->client->weaponstate = WEAPON_READY;
-            ent->client->weaponframe = FRAME_IDLE_FIRST;
+            ent->client->weaponframe = w->fire_last + 1;
             return;
         }
 
@@ -341,9 +350,9 @@ static void Weapon_Generic(edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE
 
     if ((ent->client->newweapon) && (ent->client->weaponstate != WEAPON_FIRING)) {
         ent->client->weaponstate = WEAPON_DROPPING;
-        ent->client->weaponframe = FRAME_DEACTIVATE_FIRST;
+        ent->client->weaponframe = w->idle_last + 1;
 
-        if ((FRAME_DEACTIVATE_LAST - FRAME_DEACTIVATE_FIRST) < 4) {
+        if ((w->deactivate_last - w->idle_last - 1) < 4) {
             ent->client->anim_priority = ANIM_REVERSE;
             if (ent->client->ps.pmove.pm_flags & PMF_DUCKED) {
                 ent->client->anim_start = FRAME_crpain4;
@@ -362,7 +371,7 @@ static void Weapon_Generic(edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE
             ent->client->latched_buttons &= ~BUTTON_ATTACK;
             if ((!ent->client->ammo_index) ||
                 (ent->client->inventory[ent->client->ammo_index] >= ent->client->weapon->quantity)) {
-                ent->client->weaponframe = FRAME_FIRE_FIRST;
+                ent->client->weaponframe = w->activate_last + 1;
                 ent->client->weaponstate = WEAPON_FIRING;
 
                 // start the animation
@@ -378,18 +387,14 @@ static void Weapon_Generic(edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE
                 NoAmmoWeaponChange(ent);
             }
         } else {
-            if (ent->client->weaponframe == FRAME_IDLE_LAST) {
-                ent->client->weaponframe = FRAME_IDLE_FIRST;
+            if (ent->client->weaponframe == w->idle_last) {
+                ent->client->weaponframe = w->fire_last + 1;
                 return;
             }
 
-            if (pause_frames) {
-                for (n = 0; pause_frames[n]; n++) {
-                    if (ent->client->weaponframe == pause_frames[n]) {
-                        if (Q_rand() & 15)
-                            return;
-                    }
-                }
+            if (FRAME_IN(w->pause_frames, ent->client->weaponframe)) {
+                if (Q_rand() & 15)
+                    return;
             }
 
             ent->client->weaponframe++;
@@ -398,20 +403,16 @@ static void Weapon_Generic(edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE
     }
 
     if (ent->client->weaponstate == WEAPON_FIRING) {
-        for (n = 0; fire_frames[n]; n++) {
-            if (ent->client->weaponframe == fire_frames[n]) {
-                if (ent->client->quad_framenum > level.framenum)
-                    gi.sound(ent, CHAN_ITEM, gi.soundindex("items/damage3.wav"), 1, ATTN_NORM, 0);
+        if (FRAME_IN(w->fire_frames, ent->client->weaponframe)) {
+            if (ent->client->quad_framenum > level.framenum)
+                gi.sound(ent, CHAN_ITEM, gi.soundindex("items/damage3.wav"), 1, ATTN_NORM, 0);
 
-                fire(ent);
-                break;
-            }
-        }
-
-        if (!fire_frames[n])
+            w->fire(ent);
+        } else {
             ent->client->weaponframe++;
+        }
 
-        if (ent->client->weaponframe == FRAME_IDLE_FIRST + 1)
+        if (ent->client->weaponframe == w->fire_last + 2)
             ent->client->weaponstate = WEAPON_READY;
     }
 }
@@ -444,7 +445,7 @@ static void weapon_grenade_fire(edict_t *ent, bool held)
         damage *= 4;
 
     VectorSet(offset, 8, 8, ent->viewheight - 8);
-    AngleVectors(ent->client->v_angle, forward, right, NULL);
+    G_ViewVectors(ent->client, forward, right, NULL);
     P_ProjectSource(ent->client, ent->s.origin, offset, forward, right, start);
 
     timer = ent->client->grenade_framenum - level.framenum;
@@ -583,7 +584,7 @@ static void weapon_grenadelauncher_fire(edict_t *ent)
         damage *= 4;
 
     VectorSet(offset, 8, 8, ent->viewheight - 8);
-    AngleVectors(ent->client->v_angle, forward, right, NULL);
+    G_ViewVectors(ent->client, forward, right, NULL);
     P_ProjectSource(ent->client, ent->s.origin, offset, forward, right, start);
 
     VectorScale(forward, -2, ent->client->kick_origin);
@@ -610,10 +611,14 @@ static void weapon_grenadelauncher_fire(edict_t *ent)
 
 void Weapon_GrenadeLauncher(edict_t *ent)
 {
-    static const int    pause_frames[]  = {34, 51, 59, 0};
-    static const int    fire_frames[]   = {6, 0};
-
-    Weapon_Generic(ent, 5, 16, 59, 64, pause_frames, fire_frames, weapon_grenadelauncher_fire);
+    static const weapon_frames_t    frames = {
+        5, 16, 59, 64,
+        F(34) | F(51) | F(59),
+        F(6),
+        weapon_grenadelauncher_fire
+    };
+
+    Weapon_Generic(ent, &frames);
 }
 
 /*
@@ -640,7 +645,7 @@ static void weapon_rocketlauncher_fire(edict_t *ent)
         radius_damage *= 4;
     }
 
-    AngleVectors(ent->client->v_angle, forward, right, NULL);
+    G_ViewVectors(ent->client, forward, right, NULL);
 
     VectorScale(forward, -2, ent->client->kick_origin);
     ent->client->kick_angles[0] = -1;
@@ -669,10 +674,14 @@ static void weapon_rocketlauncher_fire(edict_t *ent)
 
 void Weapon_RocketLauncher(edict_t *ent)
 {
-    static const int    pause_frames[]  = {25, 33, 42, 50, 0};
-    static const int    fire_frames[]   = {5, 0};
-
-    Weapon_Generic(ent, 4, 12, 50, 54, pause_frames, fire_frames, weapon_rocketlauncher_fire);
+    static const weapon_frames_t    frames = {
+        4, 12, 50, 54,
+        F(25) | F(33) | F(42) | F(50),
+        F(5),
+        weapon_rocketlauncher_fire
+    };
+
+    Weapon_Generic(ent, &frames);
 }
 
 
@@ -692,7 +701,7 @@ static void blaster_fire(edict_t *ent, const vec3_t g_offset, int damage, bool h
 
     if (is_quad)
         damage *= 4;
-    AngleVectors(ent->client->v_angle, forward, right, NULL);
+    G_ViewVectors(ent->client, forward, right, NULL);
     VectorSet(offset, 24, 8, ent->viewheight - 8);
     VectorAdd(offset, g_offset, offset);
     P_ProjectSource(ent->client, ent->s.origin, offset, forward, right, start);
@@ -725,10 +734,14 @@ static void weapon_blaster_fire(edict_t *ent)
 
 void Weapon_Blaster(edict_t *ent)
 {
-    static const int    pause_frames[]  = {19, 32, 0};
-    static const int    fire_frames[]   = {5, 0};
-
-    Weapon_Generic(ent, 4, 8, 52, 55, pause_frames, fire_frames, weapon_blaster_fire);
+    static const weapon_frames_t    frames = {
+        4, 8, 52, 55,
+        F(19) | F(32),
+        F(5),
+        weapon_blaster_fire
+    };
+
+    Weapon_Generic(ent, &frames);
 }
 
 
@@ -785,10 +798,14 @@ static void weapon_hyperblaster_fire(edict_t *ent)
 
 void Weapon_HyperBlaster(edict_t *ent)
 {
-    static const int    pause_frames[]  = {0};
-    static const int    fire_frames[]   = {6, 7, 8, 9, 10, 11, 0};
-
-    Weapon_Generic(ent, 5, 20, 49, 53, pause_frames, fire_frames, weapon_hyperblaster_fire);
+    static const weapon_frames_t    frames = {
+        5, 20, 49, 53,
+        0,
+        F_RANGE(6, 11),
+        weapon_hyperblaster_fire
+    };
+
+    Weapon_Generic(ent, &frames);
 }
 
 /*
@@ -873,10 +890,14 @@ static void weapon_machinegun_fire(edict_t *ent)
 
 void Weapon_Machinegun(edict_t *ent)
 {
-    static const int    pause_frames[]  = {23, 45, 0};
-    static const int    fire_frames[]   = {4, 5, 0};
-
-    Weapon_Generic(ent, 3, 5, 45, 49, pause_frames, fire_frames, weapon_machinegun_fire);
+    static const weapon_frames_t    frames = {
+        3, 5, 45, 49,
+        F(23) | F(45),
+        F(4) | F(5),
+        weapon_machinegun_fire
+    };
+
+    Weapon_Generic(ent, &frames);
 }
 
 static void weapon_chaingun_fire(edict_t *ent)
@@ -951,7 +972,7 @@ static void weapon_chaingun_fire(edict_t *ent)
     G_BeginDamage();
     for (i = 0; i < shots; i++) {
         // get start / end positions
-        AngleVectors(ent->client->v_angle, forward, right, up);
+        G_ViewVectors(ent->client, forward, right, up);
         r = 7 + crandom() * 4;
         u = crandom() * 4;
         VectorSet(offset, 0, r, u + ent->viewheight - 8);
@@ -980,10 +1001,14 @@ static void weapon_chaingun_fire(edict_t *ent)
 
 void Weapon_Chaingun(edict_t *ent)
 {
-    static const int    pause_frames[]  = {38, 43, 51, 61, 0};
-    static const int    fire_frames[]   = {5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 0};
-
-    Weapon_Generic(ent, 4, 31, 61, 64, pause_frames, fire_frames, weapon_chaingun_fire);
+    static const weapon_frames_t    frames = {
+        4, 31, 61, 64,
+        F(38) | F(43) | F(51) | F(61),
+        F_RANGE(5, 21),
+        weapon_chaingun_fire
+    };
+
+    Weapon_Generic(ent, &frames);
 }
 
 
@@ -1008,7 +1033,7 @@ static void weapon_shotgun_fire(edict_t *ent)
         return;
     }
 
-    AngleVectors(ent->client->v_angle, forward, right, NULL);
+    G_ViewVectors(ent->client, forward, right, NULL);
 
     VectorScale(forward, -2, ent->client->kick_origin);
     ent->client->kick_angles[0] = -2;
@@ -1045,10 +1070,14 @@ static void weapon_shotgun_fire(edict_t *ent)
 
 void Weapon_Shotgun(edict_t *ent)
 {
-    static const int    pause_frames[]  = {22, 28, 34, 0};
-    static const int    fire_frames[]   = {8, 9, 0};
-
-    Weapon_Generic(ent, 7, 18, 36, 39, pause_frames, fire_frames, weapon_shotgun_fire);
+    static const weapon_frames_t    frames = {
+        7, 18, 36, 39,
+        F(22) | F(28) | F(34),
+        F(8) | F(9),
+        weapon_shotgun_fire
+    };
+
+    Weapon_Generic(ent, &frames);
 }
 
 
@@ -1061,7 +1090,7 @@ static void weapon_supershotgun_fire(edict_t *ent)
     int         damage = 6;
     int         kick = 12;
 
-    AngleVectors(ent->client->v_angle, forward, right, NULL);
+    G_ViewVectors(ent->client, forward, right, NULL);
 
     VectorScale(forward, -2, ent->client->kick_origin);
     ent->client->kick_angles[0] = -2;
@@ -1105,10 +1134,14 @@ static void weapon_supershotgun_fire(edict_t *ent)
 
 void Weapon_SuperShotgun(edict_t *ent)
 {
-    static const int    pause_frames[]  = {29, 42, 57, 0};
-    static const int    fire_frames[]   = {7, 0};
-
-    Weapon_Generic(ent, 6, 17, 57, 61, pause_frames, fire_frames, weapon_supershotgun_fire);
+    static const weapon_frames_t    frames = {
+        6, 17, 57, 61,
+        F(29) | F(42) | F(57),
+        F(7),
+        weapon_supershotgun_fire
+    };
+
+    Weapon_Generic(ent, &frames);
 }
 
 
@@ -1134,7 +1167,7 @@ static void weapon_railgun_fire(edict_t *ent)
         kick *= 4;
     }
 
-    AngleVectors(ent->client->v_angle, forward, right, NULL);
+    G_ViewVectors(ent->client, forward, right, NULL);
 
     VectorScale(forward, -3, ent->client->kick_origin);
     ent->client->kick_angles[0] = -3;
@@ -1164,10 +1197,14 @@ static void weapon_railgun_fire(edict_t *ent)
 
 void Weapon_Railgun(edict_t *ent)
 {
-    static const int    pause_frames[]  = {56, 0};
-    static const int    fire_frames[]   = {4, 0};
-
-    Weapon_Generic(ent, 3, 18, 56, 61, pause_frames, fire_frames, weapon_railgun_fire);
+    static const weapon_frames_t    frames = {
+        3, 18, 56, 61,
+        F(56),
+        F(4),
+        weapon_railgun_fire
+    };
+
+    Weapon_Generic(ent, &frames);
 }
 
 
@@ -1211,7 +1248,7 @@ static void weapon_bfg_fire(edict_t *ent)
     if (is_quad)
         damage *= 4;
 
-    AngleVectors(ent->client->v_angle, forward, right, NULL);
+    G_ViewVectors(ent->client, forward, right, NULL);
 
     VectorScale(forward, -2, ent->client->kick_origin);
 
@@ -1236,10 +1273,14 @@ static void weapon_bfg_fire(edict_t *ent)
 
 void Weapon_BFG(edict_t *ent)
 {
-    static const int    pause_frames[]  = {39, 45, 50, 55, 0};
-    static const int    fire_frames[]   = {9, 17, 0};
-
-    Weapon_Generic(ent, 8, 32, 55, 58, pause_frames, fire_frames, weapon_bfg_fire);
+    static const weapon_frames_t    frames = {
+        8, 32, 55, 58,
+        F(39) | F(45) | F(50) | F(55),
+        F(9) | F(17),
+        weapon_bfg_fire
+    };
+
+    Weapon_Generic(ent, &frames);
 }
 
 